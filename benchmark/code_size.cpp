@@ -0,0 +1,37 @@
+#include "udlerrors.h"
+
+// hot path size of a CreateEvent(...) || throw_last_error_if(...) call site
+// compare the listing and the section sizes of
+//   cl /std:c++20 /O2 /EHsc /c /I..\udlerrors /FAs code_size.cpp
+//   cl /std:c++20 /O2 /EHsc /c /I..\udlerrors /FAs /DINLINE_THROW code_size.cpp
+// then dumpbin /headers code_size.obj for the .text$mn, .xdata and .pdata sizes
+// (with gcc or clang, -S for the listing and size -A code_size.o for the sections)
+// INLINE_THROW adds back the handler that built and threw the win_exception in the caller
+
+using namespace error;
+
+namespace code_size {
+#if defined(INLINE_THROW)
+	template<class T>
+	struct inline_throw_last_error_if_t
+	{
+		typedef void is_error_handler;
+
+		T invalid;
+
+		explicit inline_throw_last_error_if_t(T invalid) : invalid(invalid) {}
+
+		inline T operator()(T r) const { if (r != invalid) return r; throw win_exception{ win{ GetLastError() } }; }
+	};
+	template<class T>
+	inline_throw_last_error_if_t<T> handler(T invalid) { return inline_throw_last_error_if_t<T>(invalid); }
+#else
+	template<class T>
+	throw_last_error_if_t<T> handler(T invalid) { return throw_last_error_if(invalid); }
+#endif
+
+	// the call site measured, kept out of line so that it is one function in the listing
+	__declspec(noinline) HANDLE create_event() {
+		return CreateEvent(nullptr, TRUE, TRUE, nullptr) || handler(HANDLE(NULL));
+	}
+}
@@ -0,0 +1,57 @@
+#include "udlerrors.h"
+
+// front end cost of the error operators in a TU that mostly compares other types
+// compare the Frontend time of
+//   cl /std:c++20 /O2 /c /I..\udlerrors /d1reportTime compile_time.cpp
+//   cl /std:c++20 /O2 /c /I..\udlerrors /d1reportTime /DLEGACY_OPERATORS compile_time.cpp
+// (with gcc or clang, -ftime-report instead of /d1reportTime)
+// LEGACY_OPERATORS adds back the global SFINAE operators, which are candidates for every ==, != and || on a class type
+// the reduction has not been shown - /d1reportTime has not been run, and with g++ 12 -fsyntax-only the timings overlap
+// (12 runs each, median 1.60s in 1.40-1.93s, and 1.73s in 1.38-2.06s with LEGACY_OPERATORS)
+
+#if defined(LEGACY_OPERATORS)
+template<class T, class IsError = typename T::is_error> constexpr bool operator==(const T& lhs, const T& rhs) noexcept {
+	return lhs.value == rhs.value;
+}
+template<class T, class IsError = typename T::is_error> constexpr bool operator!=(const T& lhs, const T& rhs) noexcept {
+	return lhs.value != rhs.value;
+}
+template<class ReturnT, class T, class IsErrorHandler = typename T::is_error_handler> auto operator||(const ReturnT& result, const T& handler)
+	-> decltype(handler(result)) {
+	return		handler(result);
+}
+#endif
+
+#define SYNTHETIC_TYPE(n) \
+	struct type_##n \
+	{ \
+		int value; \
+		friend bool operator==(const type_##n&, const type_##n&) = default; \
+		explicit operator bool() const noexcept { return value != 0; } \
+	}; \
+	bool compare_##n(const type_##n& a, const type_##n& b, const type_##n& c) { \
+		return (a == b && b != c) || (a != c && c == b) || (a || b) || (b || c) || (a == type_##n{ n }) || (type_##n{ n } != c); \
+	} \
+	bool check_##n(HRESULT code) { \
+		return ok(hr{ code }) && hr{ code } != hr{ n } && !(hr{ code } == 0_hr); \
+	}
+
+#define SYNTHETIC_10(p) SYNTHETIC_TYPE(p##0) SYNTHETIC_TYPE(p##1) SYNTHETIC_TYPE(p##2) SYNTHETIC_TYPE(p##3) SYNTHETIC_TYPE(p##4) \
+	SYNTHETIC_TYPE(p##5) SYNTHETIC_TYPE(p##6) SYNTHETIC_TYPE(p##7) SYNTHETIC_TYPE(p##8) SYNTHETIC_TYPE(p##9)
+#define SYNTHETIC_100(p) SYNTHETIC_10(p##0) SYNTHETIC_10(p##1) SYNTHETIC_10(p##2) SYNTHETIC_10(p##3) SYNTHETIC_10(p##4) \
+	SYNTHETIC_10(p##5) SYNTHETIC_10(p##6) SYNTHETIC_10(p##7) SYNTHETIC_10(p##8) SYNTHETIC_10(p##9)
+
+using namespace error;
+
+namespace synthetic {
+	SYNTHETIC_100(1)
+	SYNTHETIC_100(2)
+	SYNTHETIC_100(3)
+	SYNTHETIC_100(4)
+	SYNTHETIC_100(5)
+
+#if !defined(LEGACY_OPERATORS)
+	// the ADL operator|| and the legacy one are ambiguous for a handler, so this part is only in the new build
+	result<void, hr> handle(HRESULT code) { return code || error::return_hr; }
+#endif
+}
@@ -0,0 +1,206 @@
+#include "udlerrors.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace e = error;
+using namespace error;
+
+namespace {
+	const int iterations = 10000000;
+	const int inputs = 1024; // power of 2
+
+	template<class T>
+	void do_not_optimize(const T& t) {
+		const volatile void* sink = &t; (void)sink;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	template<class F>
+	void measure(const char* name, F f, int count = iterations) {
+		for (int i = 0; i != count / 16; ++i) { f(i); }
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i != count; ++i) { f(i); }
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		std::printf("%-48s %8.2f ns/op\n", name, std::chrono::duration<double, std::nano>(elapsed).count() / count);
+	}
+
+	// every failures-th input fails, 0 for none
+	template<class V>
+	std::vector<V> make_inputs(V good, V bad, int failures) {
+		std::vector<V> v(inputs, good);
+		for (int i = 0; failures != 0 && i < inputs; i += failures) { v[i] = bad; }
+		return v;
+	}
+
+	std::vector<HANDLE> handles;
+	HANDLE fake_create(int i) {
+		HANDLE h = handles[i & (inputs - 1)];
+		if (!h) { SetLastError(ERROR_ACCESS_DENIED); }
+		return h;
+	}
+
+	__declspec(noinline) void throw_leaf(HRESULT v) { v || e::throw_hr; }
+	__declspec(noinline) void throw_mid(HRESULT v) { throw_leaf(v); }
+	__declspec(noinline) result<void, hr> return_leaf(HRESULT v) { return v || e::return_hr; }
+	__declspec(noinline) result<void, hr> return_mid(HRESULT v) { return return_leaf(v).and_then([]() { return result<void, hr>{}; }); }
+
+	// one call per error type that takes and returns it by value, layout/main.cpp asserts which of these stay in registers
+	// a type that grows or stops being trivially copyable goes through memory and shows up here
+	template<class T>
+	__declspec(noinline) T pass_by_value(T v) { return v; }
+
+	enum class next_step { fail, retry, wait };
+
+	constexpr auto after_failure = dispatch<hr, next_step>(next_step::fail)
+		.codes(FACILITY_WIN32, ERROR_SHARING_VIOLATION, ERROR_LOCK_VIOLATION, next_step::wait)
+		.code(FACILITY_WIN32, ERROR_RETRY, next_step::retry)
+		.code(FACILITY_WIN32, ERROR_NOT_READY, next_step::wait)
+		.facility(FACILITY_RPC, next_step::retry)
+		.facility(FACILITY_ITF, next_step::fail)
+		.severity(severity::success, next_step::fail)
+		.compile();
+
+	// the same decisions as after_failure, the way they were written before dispatch
+	__declspec(noinline) next_step after_failure_cascade(hr e) {
+		const ULONG v = ULONG(e.value);
+		if (LONG(v) >= 0) { return next_step::fail; }
+		if (HRESULT_FACILITY(v) == FACILITY_WIN32) {
+			const ULONG code = HRESULT_CODE(v);
+			if (code >= ERROR_SHARING_VIOLATION && code <= ERROR_LOCK_VIOLATION) { return next_step::wait; }
+			else if (code == ERROR_RETRY) { return next_step::retry; }
+			else if (code == ERROR_NOT_READY) { return next_step::wait; }
+			return next_step::fail;
+		}
+		else if (HRESULT_FACILITY(v) == FACILITY_RPC) { return next_step::retry; }
+		else if (HRESULT_FACILITY(v) == FACILITY_ITF) { return next_step::fail; }
+		return next_step::fail;
+	}
+
+	// compare the sections of a default build with a /EHs-c- build (the ReleaseNoExcept configuration)
+	void size_report() {
+		const BYTE* base = reinterpret_cast<const BYTE*>(GetModuleHandleW(nullptr));
+		const IMAGE_NT_HEADERS* headers = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + reinterpret_cast<const IMAGE_DOS_HEADER*>(base)->e_lfanew);
+		std::printf("UDLERRORS_EXCEPTIONS %d, image %lu bytes\n", UDLERRORS_EXCEPTIONS, static_cast<unsigned long>(headers->OptionalHeader.SizeOfImage));
+		const IMAGE_SECTION_HEADER* section = IMAGE_FIRST_SECTION(headers);
+		for (int i = 0; i != headers->FileHeader.NumberOfSections; ++i, ++section) {
+			std::printf("  %-8.8s %8lu bytes\n", reinterpret_cast<const char*>(section->Name), static_cast<unsigned long>(section->Misc.VirtualSize));
+		}
+	}
+}
+
+int wmain() {
+	char name[64];
+
+	size_report();
+
+	{
+		auto w = make_inputs<DWORD>(NOERROR, ERROR_ACCESS_DENIED, 0);
+		auto n = make_inputs<NTSTATUS>(STATUS_SUCCESS, STATUS_ACCESS_DENIED, 0);
+		auto h = make_inputs<HRESULT>(S_OK, E_FAIL, 0);
+
+		measure("ok(win)", [&](int i) { do_not_optimize(ok(win{ w[i & (inputs - 1)] })); });
+		measure("ok(nt)", [&](int i) { do_not_optimize(ok(nt{ n[i & (inputs - 1)] })); });
+		measure("ok(hr)", [&](int i) { do_not_optimize(ok(hr{ h[i & (inputs - 1)] })); });
+
+		measure("unique_error<win> construct/check/destroy", [&](int i) { unique_error<win> u{ w[i & (inputs - 1)] }; do_not_optimize(u.ok()); });
+		measure("unique_error<nt> construct/check/destroy", [&](int i) { unique_error<nt> u{ n[i & (inputs - 1)] }; do_not_optimize(u.ok()); });
+		measure("unique_error<hr> construct/check/destroy", [&](int i) { unique_error<hr> u{ h[i & (inputs - 1)] }; do_not_optimize(u.ok()); });
+
+		unique_error<win> uw; unique_error<nt> un; unique_error<hr> uh;
+		measure("unique_error<win> reset/release", [&](int i) { uw.reset(w[i & (inputs - 1)]); do_not_optimize(uw.release()); });
+		measure("unique_error<nt> reset/release", [&](int i) { un.reset(n[i & (inputs - 1)]); do_not_optimize(un.release()); });
+		measure("unique_error<hr> reset/release", [&](int i) { uh.reset(h[i & (inputs - 1)]); do_not_optimize(uh.release()); });
+
+		measure("|| return_nt", [&](int i) { do_not_optimize(n[i & (inputs - 1)] || e::return_nt); });
+		measure("|| return_hr", [&](int i) { do_not_optimize(h[i & (inputs - 1)] || e::return_hr); });
+		measure("|| throw_nt", [&](int i) { n[i & (inputs - 1)] || e::throw_nt; });
+		measure("|| throw_hr", [&](int i) { h[i & (inputs - 1)] || e::throw_hr; });
+
+		handles = make_inputs<HANDLE>(INVALID_HANDLE_VALUE, HANDLE(NULL), 0);
+		measure("|| last_error_if", [&](int i) { do_not_optimize(fake_create(i) || last_error_if(HANDLE(NULL))); });
+		measure("|| throw_last_error_if", [&](int i) { do_not_optimize(fake_create(i) || throw_last_error_if(HANDLE(NULL))); });
+
+		measure("count_failures<hr>, per element", [&](int i) { if ((i & (inputs - 1)) == 0) { do_not_optimize(count_failures<hr>(h)); } });
+		measure("ok(hr) loop, per element", [&](int i) { if ((i & (inputs - 1)) == 0) { size_t c = 0; for (HRESULT v : h) { c += ok(hr{ v }) ? 0 : 1; do_not_optimize(c); } } });
+		measure("|| return_each<hr>, 64 codes, per element", [&](int i) { if ((i & 63) == 0) { do_not_optimize(std::span<const HRESULT>(h.data() + (i & (inputs - 1)), 64) || e::return_each<hr>); } });
+		measure("|| return_hr loop, 64 codes, per element", [&](int i) { if ((i & 63) == 0) { for (int k = 0; k != 64; ++k) { do_not_optimize(h[(i & (inputs - 1)) + k] || e::return_hr); } } });
+
+		first_error<hr> first;
+		measure("first_error<hr> cancelled/set", [&](int i) { if (!first.cancelled()) { do_not_optimize(first.set(hr{ h[i & (inputs - 1)] })); } });
+		first.join().release();
+
+#if UDLERRORS_LOG
+		if (ok(open_error_log(L"benchmark.errors", 1 << 16))) {
+			auto failing = make_inputs<HRESULT>(E_FAIL, E_FAIL, 0);
+			measure("|| return_hr failure, logged", [&](int i) { do_not_optimize(failing[i & (inputs - 1)] || e::return_hr); });
+			close_error_log();
+		}
+#endif
+
+#if UDLERRORS_ERROR_INFO
+		{
+			// a failure without error info, as most are - the cost of asking COM for it
+			auto failing = make_inputs<HRESULT>(E_FAIL, E_FAIL, 0);
+			measure("|| return_hr failure, error info stashed", [&](int i) { do_not_optimize(failing[i & (inputs - 1)] || e::return_hr); });
+		}
+#endif
+
+		std::error_code code = win{ ERROR_ACCESS_DENIED };
+		measure("win == std::error_code", [&](int i) { do_not_optimize(win{ w[i & (inputs - 1)] } == code); });
+		measure("std::error_code == std::error_code", [&](int i) { do_not_optimize(std::error_code(win{ w[i & (inputs - 1)] }) == code); });
+		measure("win == std::errc", [&](int i) { do_not_optimize(win{ w[i & (inputs - 1)] } == std::errc::permission_denied); });
+		measure("std::error_code == std::errc, virtual", [&](int i) { do_not_optimize(std::error_code(win{ w[i & (inputs - 1)] }) == std::errc::permission_denied); });
+
+		std::vector<HRESULT> failures(inputs);
+		const HRESULT kinds[] = { E_FAIL, HRESULT_FROM_WIN32(ERROR_SHARING_VIOLATION), HRESULT_FROM_WIN32(ERROR_RETRY), HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED), HRESULT(0x800706BA), HRESULT(0x80040154) };
+		for (int i = 0; i != inputs; ++i) { failures[i] = kinds[(unsigned(i) * 2654435761u >> 16) % 6]; } // no pattern for the branch predictor to learn
+		measure("dispatch table, mixed hr failures", [&](int i) { do_not_optimize(after_failure(hr{ failures[i & (inputs - 1)] })); });
+		measure("if/else cascade, mixed hr failures", [&](int i) { do_not_optimize(after_failure_cascade(hr{ failures[i & (inputs - 1)] })); });
+
+		const auto transient = retry_if({ hr{ HRESULT_FROM_WIN32(ERROR_SHARING_VIOLATION) } });
+		measure("retry_if || return_hr, no retries", [&](int i) { do_not_optimize(transient || [&]() { return h[i & (inputs - 1)] || e::return_hr; }); });
+
+		measure("by value: HRESULT", [&](int i) { do_not_optimize(pass_by_value(h[i & (inputs - 1)])); });
+		measure("by value: hr", [&](int i) { do_not_optimize(pass_by_value(hr{ h[i & (inputs - 1)] })); });
+		measure("by value: result<void, hr>", [&](int i) { do_not_optimize(pass_by_value(result<void, hr>{ hr{ h[i & (inputs - 1)] } })); });
+		measure("by value: result<BOOL, win>", [&](int i) { do_not_optimize(pass_by_value(result<BOOL, win>{ win{ w[i & (inputs - 1)] }, TRUE })); });
+		measure("by value: pending_result<void, nt>", [&](int i) { do_not_optimize(pass_by_value(pending_result<void, nt>{ nt{ n[i & (inputs - 1)] } })); });
+		measure("by value: unique_error<hr, no_check>, returned in memory", [&](int i) { do_not_optimize(pass_by_value(unique_error<hr, no_check>{ h[i & (inputs - 1)] })); });
+		measure("by value: retry_result<hr>", [&](int i) { do_not_optimize(pass_by_value(retry_result<hr>{ hr{ h[i & (inputs - 1)] }, 0 })); });
+		measure("by value: result<HANDLE, win>, in memory", [&](int i) { do_not_optimize(pass_by_value(result<HANDLE, win>{ win{ w[i & (inputs - 1)] }, nullptr })); });
+
+		typedef NTSTATUS(NTAPI* query_thread_t)(HANDLE, THREADINFOCLASS, PVOID, ULONG, PULONG);
+		measure("ntdll::NtQueryInformationThread, table", [&](int) { ULONG v = 0; do_not_optimize(ntdll::NtQueryInformationThread(GetCurrentThread(), ThreadIsIoPending, &v, sizeof(v), nullptr)); });
+		measure("NtQueryInformationThread, GetProcAddress", [&](int) {
+			ULONG v = 0;
+			auto query = reinterpret_cast<query_thread_t>(GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationThread"));
+			do_not_optimize(query(GetCurrentThread(), ThreadIsIoPending, &v, sizeof(v), nullptr) || e::return_nt);
+		}, iterations / 10);
+
+		measure("message(win) cached", [&](int i) { do_not_optimize(message(win{ w[i & (inputs - 1)] })); });
+		measure("message(hr) cached", [&](int i) { do_not_optimize(message(hr{ h[i & (inputs - 1)] })); });
+	}
+
+	// two frames of propagation, by exception and by return value
+	const int rates[] = { 0, 1000, 100, 10, 2 };
+	for (int rate : rates) {
+		auto h = make_inputs<HRESULT>(S_OK, E_FAIL, rate);
+		double percent = rate == 0 ? 0.0 : 100.0 / rate;
+
+#if UDLERRORS_EXCEPTIONS
+		std::snprintf(name, sizeof(name), "throw_hr propagation, %.1f%% failures", percent);
+		measure(name, [&](int i) { try { throw_mid(h[i & (inputs - 1)]); } catch (const hr_exception& ex) { do_not_optimize(ex.error); } }, iterations / 10);
+#else
+		failure_hook previous = set_failure_hook(&record_on_failure);
+		std::snprintf(name, sizeof(name), "throw_hr to failure hook, %.1f%% failures", percent);
+		measure(name, [&](int i) { throw_mid(h[i & (inputs - 1)]); do_not_optimize(take_failure()); }, iterations / 10);
+		set_failure_hook(previous);
+#endif
+
+		std::snprintf(name, sizeof(name), "return_hr propagation, %.1f%% failures", percent);
+		measure(name, [&](int i) { do_not_optimize(return_mid(h[i & (inputs - 1)])); }, iterations / 10);
+	}
+}
@@ -0,0 +1,129 @@
+#include "udlerrors.h"
+
+#include <dbghelp.h>
+#include <cstdio>
+
+#pragma comment(lib, "dbghelp.lib")
+
+// errorlog <log file> [<module that wrote it>]
+// prints the records of a log written with UDLERRORS_LOG, oldest first, with the FormatMessage text of each code
+// when the module is given, its pdb resolves each call site to function and file(line)
+
+using namespace error;
+
+namespace {
+	std::wstring_view text(const error_record& r) {
+		switch (r.source) {
+		case domain::win: return message(win{ DWORD(r.code) });
+		case domain::nt: return message(nt{ NTSTATUS(r.code) });
+		case domain::hr: return message(hr{ HRESULT(r.code) });
+		default: return std::wstring_view();
+		}
+	}
+
+	int report(const wchar_t* path, win e) {
+		auto reason = message(e);
+		std::fwprintf(stderr, L"%ls: %.*ls\n", path, int(reason.size()), reason.data());
+		return 1;
+	}
+
+	// the module is loaded for its symbols only, at a fixed base so that base + rva is a call site
+	const ULONGLONG symbol_base = 0x10000000;
+
+	void print_site(HANDLE process, ULONG site) {
+		std::wprintf(L" +0x%08lX", static_cast<unsigned long>(site));
+		if (!process) {
+			return;
+		}
+		union
+		{
+			SYMBOL_INFOW info;
+			BYTE storage[sizeof(SYMBOL_INFOW) + MAX_SYM_NAME * sizeof(WCHAR)];
+		} symbol = {};
+		symbol.info.SizeOfStruct = sizeof(SYMBOL_INFOW);
+		symbol.info.MaxNameLen = MAX_SYM_NAME;
+		ULONGLONG displacement = 0;
+		if (SymFromAddrW(process, symbol_base + site, &displacement, &symbol.info)) {
+			std::wprintf(L" %ls", symbol.info.Name);
+		}
+		IMAGEHLP_LINEW64 line = {};
+		line.SizeOfStruct = sizeof(line);
+		DWORD column = 0;
+		if (SymGetLineFromAddrW64(process, symbol_base + site, &column, &line)) {
+			std::wprintf(L" %ls(%lu)", line.FileName, static_cast<unsigned long>(line.LineNumber));
+		}
+	}
+}
+
+int wmain(int argc, wchar_t** argv) {
+	if (argc < 2) {
+		std::fwprintf(stderr, L"usage: errorlog <log file> [<module that wrote it>]\n");
+		return 2;
+	}
+
+	// the writer keeps the file open for write, so share write to read a live log
+	auto file = CreateFileW(argv[1], GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) || make_handle_or_error<invalid_handle_traits>();
+	if (!file) {
+		return report(argv[1], file.error().release());
+	}
+	LARGE_INTEGER size = {};
+	auto sized = GetFileSizeEx(file.get(), &size) || last_error_if(FALSE);
+	if (!sized) {
+		return report(argv[1], sized.error());
+	}
+	if (ULONGLONG(size.QuadPart) < sizeof(error_log_header)) {
+		std::fwprintf(stderr, L"%ls: not an error log\n", argv[1]);
+		return 1;
+	}
+	auto mapping = CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr) || make_handle_or_error<null_handle_traits>();
+	if (!mapping) {
+		return report(argv[1], mapping.error().release());
+	}
+	auto view = MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0) || last_error_if(LPVOID(nullptr));
+	if (!view) {
+		return report(argv[1], view.error());
+	}
+	const error_log_header* log = static_cast<const error_log_header*>(view.value());
+	if (log->magic != error_log_header::expected_magic || log->version != error_log_header::expected_version || log->record_size != sizeof(error_record) ||
+		ULONGLONG(size.QuadPart) < sizeof(error_log_header) + ULONGLONG(log->capacity) * sizeof(error_record)) {
+		std::fwprintf(stderr, L"%ls: not an error log, or written by a different version\n", argv[1]);
+		UnmapViewOfFile(log);
+		return 1;
+	}
+
+	HANDLE process = nullptr;
+	if (argc > 2) {
+		SymSetOptions(SYMOPT_LOAD_LINES | SYMOPT_UNDNAME);
+		if (SymInitializeW(GetCurrentProcess(), nullptr, FALSE) && SymLoadModuleExW(GetCurrentProcess(), nullptr, argv[2], nullptr, symbol_base, 0, nullptr, 0) != 0) {
+			process = GetCurrentProcess();
+		}
+		else {
+			std::fwprintf(stderr, L"%ls: no symbols, call sites are printed as rvas\n", argv[2]);
+		}
+	}
+
+	const ULONGLONG last = log->next.load(std::memory_order_acquire);
+	const ULONGLONG first = last > log->capacity ? last - log->capacity : 0;
+	std::wprintf(L"%llu records, %llu overwritten\n", last - first, first);
+	for (ULONGLONG n = first; n != last; ++n) {
+		const error_record& r = log->records()[n & (log->capacity - 1)];
+		if (r.time == 0) {
+			continue; // claimed, but not written before the writer stopped
+		}
+		FILETIME time = { DWORD(r.time), DWORD(r.time >> 32) };
+		SYSTEMTIME utc = {};
+		FileTimeToSystemTime(&time, &utc);
+		std::wprintf(L"%04u-%02u-%02u %02u:%02u:%02u.%03u %5lu %-20hs %-4hs 0x%08lX",
+			utc.wYear, utc.wMonth, utc.wDay, utc.wHour, utc.wMinute, utc.wSecond, utc.wMilliseconds,
+			static_cast<unsigned long>(r.thread), handler_name(r.handler), domain_name(r.source), static_cast<unsigned long>(r.code));
+		print_site(process, r.site);
+		auto t = text(r);
+		std::wprintf(L": %.*ls\n", int(t.size()), t.data());
+	}
+
+	if (process) {
+		SymCleanup(process);
+	}
+	UnmapViewOfFile(log);
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include "udlerrors.h"
+
+// the layout and calling convention of the library types, checked when this project builds
+// built for Win32 and x64, so sizes that depend on the pointer size or on the alignment of ULONGLONG are rounded as the compiler does
+
+using namespace error;
+
+namespace {
+	// the x64 and arm64 conventions pass a class in a register when it is 1, 2, 4 or 8 bytes and trivially copyable and destructible
+	// otherwise the caller makes a copy in memory and passes its address
+	template<class T>
+	constexpr bool passed_in_register = std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value
+		&& (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+	// MSVC x64 returns a class in RAX only when it also has no user-declared constructors, no private members and no bases
+	// is_aggregate rules out the constructors and the private members, the types checked here have no bases
+	template<class T>
+	constexpr bool returned_in_register = passed_in_register<T> && (std::is_scalar<T>::value || std::is_aggregate<T>::value);
+
+	constexpr size_t round_up(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+}
+
+// the error types
+static_assert(sizeof(win) == 4 && alignof(win) == 4 && std::is_standard_layout<win>::value && returned_in_register<win>, "win must be a 4 byte value returned in a register");
+static_assert(sizeof(nt) == 4 && alignof(nt) == 4 && std::is_standard_layout<nt>::value && returned_in_register<nt>, "nt must be a 4 byte value returned in a register");
+static_assert(sizeof(hr) == 4 && alignof(hr) == 4 && std::is_standard_layout<hr>::value && returned_in_register<hr>, "hr must be a 4 byte value returned in a register");
+
+// the results of the handlers
+static_assert(returned_in_register<result<void, win>> && returned_in_register<result<BOOL, win>> && returned_in_register<pending_result<BOOL, win>>, "win results must be returned in a register");
+static_assert(returned_in_register<result<void, nt>> && returned_in_register<pending_result<void, nt>> && returned_in_register<result<ULONG, nt>>, "nt results must be returned in a register");
+static_assert(returned_in_register<result<void, hr>> && returned_in_register<result<int, hr>>, "hr results must be returned in a register");
+static_assert(returned_in_register<retry_result<win>> && returned_in_register<retry_result<hr>> && returned_in_register<retry_result<result<void, nt>>>, "retry_result of an error must be returned in a register");
+static_assert(std::is_trivially_copyable<result<HANDLE, win>>::value && sizeof(result<HANDLE, win>) == round_up(sizeof(win) + sizeof(HANDLE), alignof(HANDLE)), "result<HANDLE, win> is the error and the handle");
+static_assert(sizeof(result<void, hr>) == sizeof(hr) && sizeof(result<BOOL, win>) == 8 && sizeof(pending_result<BOOL, win>) == sizeof(result<BOOL, win>), "pending_result must not add a state field");
+
+// unique_error has constructors, so it is passed in a register but returned in memory
+static_assert(passed_in_register<unique_error<win, no_check>> && passed_in_register<unique_error<nt, no_check>> && passed_in_register<unique_error<hr, no_check>>, "unique_error<T, no_check> must be passed in a register");
+static_assert(!returned_in_register<unique_error<hr, no_check>>, "unique_error is not an aggregate");
+static_assert(sizeof(unique_error<hr, terminate_if_unchecked>) == 2 * sizeof(hr), "terminate_if_unchecked must not store a call site");
+static_assert(sizeof(unique_error<win, packed_check<terminate_if_unchecked>>) == sizeof(win) && sizeof(unique_error<nt, packed_check<terminate_if_unchecked>>) == sizeof(nt) && sizeof(unique_error<hr, packed_check<terminate_if_unchecked>>) == sizeof(hr), "a packed unique_error must be a bare error");
+static_assert(std::is_nothrow_move_constructible<unique_error<hr, terminate_if_unchecked>>::value && std::is_nothrow_move_assignable<unique_error<hr, terminate_if_unchecked>>::value, "unique_error must be nothrow movable so containers move it");
+
+// unique_handle
+static_assert(sizeof(unique_handle<null_handle_traits, terminate_if_unchecked>) <= 16 && sizeof(unique_handle<invalid_handle_traits, no_check>) <= 16, "unique_handle must fit in 16 bytes");
+static_assert(!std::is_copy_constructible<unique_null_handle>::value && std::is_nothrow_move_constructible<unique_null_handle>::value && std::is_nothrow_move_assignable<unique_null_handle>::value, "unique_handle must be move only");
+
+// the types that hold several errors
+static_assert(sizeof(shared_error<hr, no_check>) == sizeof(hr) && std::is_trivially_destructible<shared_error<hr, no_check>>::value, "shared_error<T, no_check> must be a bare T");
+static_assert(sizeof(shared_error<hr, terminate_if_unchecked>) == 2 * sizeof(hr), "shared_error must only add the flag");
+static_assert(sizeof(padded_shared_error<hr>) == 64 && alignof(padded_shared_error<hr>) == 64, "padded_shared_error must fill one cache line");
+static_assert(sizeof(first_error<hr>) == 64 && alignof(first_error<hr>) == 64, "first_error must fill one cache line");
+static_assert(std::is_trivially_copyable<batch_result<hr>>::value && alignof(batch_result<hr>) == alignof(ULONGLONG), "batch_result must be a trivially copyable value");
+static_assert(sizeof(batch_result<hr>) == round_up(sizeof(ULONGLONG) + MAXIMUM_WAIT_OBJECTS * sizeof(hr) + 2 * sizeof(size_t), alignof(ULONGLONG)), "batch_result must be the bitmap, the codes and the counts");
+static_assert(sizeof(task<void>) == sizeof(void*), "task must be the coroutine handle");
+
+// the dispatch tables
+static_assert(sizeof(severity) == 1 && std::is_trivially_copyable<dispatch_rule<bool>>::value, "dispatch rules must stay small values");
+static_assert(std::is_trivially_copyable<dispatch_table<hr, bool, 4>>::value && sizeof(dispatch_table<hr, bool, 4>) <= dispatch_traits<hr>::facilities + 64, "a dispatch_table is the facility bytes and a few small arrays");
+
+#if UDLERRORS_ERROR_INFO
+static_assert(std::is_trivially_destructible<detail::error_info_stash>::value, "the stash must not release COM references at thread exit");
+#endif
+#if UDLERRORS_EXCEPTIONS
+static_assert(sizeof(error_exception) <= sizeof(std::exception) + 144, "error_exception must stay the text buffer, the code and a few flags");
+static_assert(sizeof(hr_exception) <= 192, "hr_exception must stay small enough to throw without a heap copy");
+#endif
+
+int wmain() {
+	return 0;
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "core.h"
+#include "hooks.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+
+#if !defined(UDLERRORS_SIMD)
+#if defined(__AVX2__)
+#define UDLERRORS_SIMD 2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UDLERRORS_SIMD 1
+#else
+#define UDLERRORS_SIMD 0
+#endif
+#endif
+
+#if UDLERRORS_SIMD
+#include <immintrin.h>
+#endif
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			// failure tests on the raw 32bit value, the same tests as ok() for each domain
+			template<domain D> constexpr bool failed(ULONG v) noexcept;
+			template<> constexpr bool failed<domain::win>(ULONG v) noexcept { return v != 0; }
+			template<> constexpr bool failed<domain::nt>(ULONG v) noexcept { return (v >> 30) == 3; }
+			template<> constexpr bool failed<domain::hr>(ULONG v) noexcept { return LONG(v) < 0; }
+
+#if UDLERRORS_SIMD == 2
+			inline constexpr size_t simd_width = 8;
+			typedef __m256i simd_t;
+			inline simd_t simd_load(const ULONG* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+			inline void simd_store(ULONG* p, simd_t v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+			template<domain D> unsigned simd_mask(simd_t v) noexcept;
+			template<> inline unsigned simd_mask<domain::win>(simd_t v) noexcept { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, _mm256_setzero_si256())))) ^ 0xFFu; }
+			template<> inline unsigned simd_mask<domain::nt>(simd_t v) noexcept { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(v, _mm256_slli_epi32(v, 1))))); }
+			template<> inline unsigned simd_mask<domain::hr>(simd_t v) noexcept { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(v))); }
+#elif UDLERRORS_SIMD == 1
+			inline constexpr size_t simd_width = 4;
+			typedef __m128i simd_t;
+			inline simd_t simd_load(const ULONG* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+			inline void simd_store(ULONG* p, simd_t v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+			template<domain D> unsigned simd_mask(simd_t v) noexcept;
+			template<> inline unsigned simd_mask<domain::win>(simd_t v) noexcept { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm_setzero_si128())))) ^ 0xFu; }
+			template<> inline unsigned simd_mask<domain::nt>(simd_t v) noexcept { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(v, _mm_slli_epi32(v, 1))))); }
+			template<> inline unsigned simd_mask<domain::hr>(simd_t v) noexcept { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(v))); }
+#endif
+
+#if UDLERRORS_SIMD
+			// one bit per failed code, two vectors per block
+			inline constexpr size_t simd_block = 2 * simd_width;
+			template<domain D>
+			inline unsigned block_failures(const ULONG* p) noexcept {
+				return simd_mask<D>(simd_load(p)) | (simd_mask<D>(simd_load(p + simd_width)) << simd_width);
+			}
+			// the same, and copies the block to out
+			template<domain D>
+			inline unsigned copy_block_failures(const ULONG* p, ULONG* out) noexcept {
+				const simd_t low = simd_load(p);
+				const simd_t high = simd_load(p + simd_width);
+				simd_store(out, low);
+				simd_store(out + simd_width, high);
+				return simd_mask<D>(low) | (simd_mask<D>(high) << simd_width);
+			}
+#endif
+
+			template<domain D>
+			size_t first_failure(const ULONG* p, size_t n) noexcept {
+				size_t i = 0;
+#if UDLERRORS_SIMD
+				for (; i + simd_block <= n; i += simd_block) {
+					if (unsigned mask = block_failures<D>(p + i)) {
+						return i + size_t(std::countr_zero(mask));
+					}
+				}
+#endif
+				for (; i != n; ++i) {
+					if (failed<D>(p[i])) {
+						return i;
+					}
+				}
+				return n;
+			}
+
+			template<domain D>
+			size_t count_failures(const ULONG* p, size_t n) noexcept {
+				size_t i = 0, count = 0;
+#if UDLERRORS_SIMD
+				for (; i + simd_block <= n; i += simd_block) {
+					count += size_t(std::popcount(block_failures<D>(p + i)));
+				}
+#endif
+				for (; i != n; ++i) {
+					count += failed<D>(p[i]) ? 1 : 0;
+				}
+				return count;
+			}
+
+			// copies n codes to out and sets one bit in bits for each failure, bits must start out zero
+			template<domain D>
+			void classify(const ULONG* p, size_t n, ULONG* out, ULONGLONG* bits) noexcept {
+				size_t i = 0;
+#if UDLERRORS_SIMD
+				static_assert(64 % simd_block == 0, "a block must not straddle two bitmap words");
+				for (; i + simd_block <= n; i += simd_block) {
+					bits[i / 64] |= ULONGLONG(copy_block_failures<D>(p + i, out + i)) << (i % 64);
+				}
+#endif
+				for (; i != n; ++i) {
+					out[i] = p[i];
+					bits[i / 64] |= ULONGLONG(failed<D>(p[i]) ? 1 : 0) << (i % 64);
+				}
+			}
+
+			template<class T>
+			using raw_t = typename std::remove_cv<decltype(std::declval<T&>().value)>::type;
+
+			template<class T>
+			const ULONG* raw(std::span<const T> s) noexcept {
+				static_assert(sizeof(T) == sizeof(ULONG) && std::is_standard_layout<T>::value, "bulk classification requires a 32bit standard layout value");
+				return reinterpret_cast<const ULONG*>(s.data());
+			}
+		}
+
+		// bulk classification over contiguous error values, or over the raw codes of an error type
+		// error::all_ok<hr>(results) accepts a range of hr or of HRESULT
+
+		template<class T, class IsError = typename T::is_error>
+		size_t first_failure(std::span<const T> errors) noexcept { return detail::first_failure<T::error_domain>(detail::raw(errors), errors.size()); }
+		template<class T, class IsError = typename T::is_error>
+		size_t first_failure(std::span<const detail::raw_t<T>> codes) noexcept { return detail::first_failure<T::error_domain>(detail::raw(codes), codes.size()); }
+
+		template<class T, class IsError = typename T::is_error>
+		bool all_ok(std::span<const T> errors) noexcept { return first_failure<T>(errors) == errors.size(); }
+		template<class T, class IsError = typename T::is_error>
+		bool all_ok(std::span<const detail::raw_t<T>> codes) noexcept { return first_failure<T>(codes) == codes.size(); }
+
+		template<class T, class IsError = typename T::is_error>
+		size_t count_failures(std::span<const T> errors) noexcept { return detail::count_failures<T::error_domain>(detail::raw(errors), errors.size()); }
+		template<class T, class IsError = typename T::is_error>
+		size_t count_failures(std::span<const detail::raw_t<T>> codes) noexcept { return detail::count_failures<T::error_domain>(detail::raw(codes), codes.size()); }
+
+		// moves the failures to the end, in no particular order, and returns the index of the first failure
+		template<class T, class IsError = typename T::is_error>
+		size_t partition_failures(std::span<T> errors) noexcept {
+			return size_t(std::partition(errors.begin(), errors.end(), [](const T& e) { return !detail::failed<T::error_domain>(ULONG(e.value)); }) - errors.begin());
+		}
+		template<class T, class IsError = typename T::is_error>
+		size_t partition_failures(std::span<detail::raw_t<T>> codes) noexcept {
+			return size_t(std::partition(codes.begin(), codes.end(), [](detail::raw_t<T> v) { return !detail::failed<T::error_domain>(ULONG(v)); }) - codes.begin());
+		}
+	}
+}
+
+namespace error {
+	inline namespace v0_1_0 {
+		// first_error<T> - the first failure reported by any number of workers
+		// set() is one compare-exchange on the code, cancelled() is one relaxed load that workers poll to stop early
+		// join() after the workers finish, the result must be checked like any unique_error
+		// (named first_error because first_failure is the bulk search)
+		template<class T, class CheckPolicy = default_check, class IsError = typename T::is_error>
+		class alignas(64) first_error
+		{
+			// 0 is ok in every domain and never a failure, so it marks that nothing has failed
+			static_assert(ULONG(T{}.value) == 0, "first_error requires T{} to have the value 0");
+
+			std::atomic<ULONG> code;
+
+		public:
+			first_error() noexcept : code(0) {}
+
+			first_error(const first_error&) = delete;
+			first_error& operator=(const first_error&) = delete;
+
+			// returns false when e is a failure that was not the first
+			bool set(const T& e) noexcept {
+				if (error::ok(e)) [[likely]] {
+					return true;
+				}
+				ULONG expected = 0;
+				return code.compare_exchange_strong(expected, ULONG(e.value), std::memory_order_release, std::memory_order_relaxed);
+			}
+			// counts as checking e
+			template<class P>
+			bool set(const unique_error<T, P>& e) noexcept { return e.ok() || set(e.get()); }
+			template<class U>
+			bool set(const result<U, T>& r) noexcept { return set(r.error()); }
+
+			bool cancelled() const noexcept { return code.load(std::memory_order_relaxed) != 0; }
+
+			unique_error<T, CheckPolicy> join(const std::source_location& where = std::source_location::current()) const noexcept {
+				return unique_error<T, CheckPolicy>{ T{ detail::raw_t<T>(code.load(std::memory_order_acquire)) }, where };
+			}
+
+			// for the next batch, once every worker is done
+			void reset() noexcept { code.store(0, std::memory_order_relaxed); }
+		};
+	}
+}
+
+namespace error {
+	inline namespace v0_1_0 {
+		// batch_result<E, N> - the outcome of up to N calls, a failure bitmap and the code of each call
+		// N defaults to MAXIMUM_WAIT_OBJECTS, the size of the handle arrays that are usually batched
+		// codes || return_each<E> classifies a whole range in one pass, push() adds calls one at a time
+		// for calls that report through GetLastError, push(call() || last_error_if(...)) reads it only for the calls that failed
+		// codes past N are not kept, they make the batch overflowed() and never ok() - split larger ranges into batches of N
+		template<class E, size_t N = MAXIMUM_WAIT_OBJECTS, class IsError = typename E::is_error>
+		class [[nodiscard]] batch_result
+		{
+			static_assert(sizeof(E) == sizeof(ULONG) && std::is_standard_layout<E>::value, "batch_result requires a 32bit standard layout value");
+
+			static const size_t words = (N + 63) / 64;
+
+			std::array<ULONGLONG, words> bits;
+			// the raw codes are not initialized, only the first count are written and each is wrapped in E when read
+			std::array<detail::raw_t<E>, N> values;
+			size_t count;
+			size_t dropped; // codes that did not fit
+
+		public:
+			typedef E error_type;
+			static const size_t capacity = N;
+
+			batch_result() noexcept : bits{}, count(0), dropped(0) {}
+
+			// replaces the batch, the first N codes are kept
+			void assign(std::span<const detail::raw_t<E>> raw) noexcept {
+				bits = {};
+				count = raw.size() < N ? raw.size() : N;
+				dropped = raw.size() - count;
+				detail::classify<E::error_domain>(reinterpret_cast<const ULONG*>(raw.data()), count, reinterpret_cast<ULONG*>(values.data()), bits.data());
+			}
+			void assign(std::span<const E> errors) noexcept { assign(std::span<const detail::raw_t<E>>(reinterpret_cast<const detail::raw_t<E>*>(errors.data()), errors.size())); }
+
+			void push(const E& e) noexcept {
+				if (count == N) [[unlikely]] {
+					++dropped;
+					return;
+				}
+				bits[count / 64] |= ULONGLONG(error::ok(e) ? 0 : 1) << (count % 64);
+				values[count++] = e.value;
+			}
+			template<class T>
+			void push(const result<T, E>& r) noexcept { push(r.error()); }
+
+			// the number of codes kept, at most N
+			size_t size() const noexcept { return count; }
+
+			// more than N codes were given, the outcome of the calls past N is unknown
+			bool overflowed() const noexcept { return dropped != 0; }
+			size_t overflow() const noexcept { return dropped; }
+
+			bool ok() const noexcept {
+				ULONGLONG any = 0;
+				for (ULONGLONG w : bits) { any |= w; }
+				return any == 0 && dropped == 0;
+			}
+			explicit operator bool() const noexcept { return ok(); }
+
+			// the failures among the codes kept
+			size_t failures() const noexcept {
+				size_t n = 0;
+				for (ULONGLONG w : bits) { n += size_t(std::popcount(w)); }
+				return n;
+			}
+			bool failed(size_t i) const noexcept { return ((bits[i / 64] >> (i % 64)) & 1) != 0; }
+
+			// the index of the first failure at or after i, size() when there is none
+			size_t next_failure(size_t i = 0) const noexcept {
+				for (size_t w = i / 64; i < count && w != words; ++w, i = w * 64) {
+					if (ULONGLONG rest = bits[w] >> (i % 64)) {
+						return i + size_t(std::countr_zero(rest));
+					}
+				}
+				return count;
+			}
+
+			// f(index, error) for each failure, in order
+			template<class F>
+			void for_each_failure(F f) const {
+				for (size_t w = 0; w != words; ++w) {
+					for (ULONGLONG rest = bits[w]; rest != 0; rest &= rest - 1) {
+						const size_t i = w * 64 + size_t(std::countr_zero(rest));
+						f(i, E{ values[i] });
+					}
+				}
+			}
+
+			E error(size_t i) const noexcept { return E{ values[i] }; }
+			std::span<const detail::raw_t<E>> codes() const noexcept { return std::span<const detail::raw_t<E>>(values.data(), count); }
+			std::span<const ULONGLONG> bitmap() const noexcept { return std::span<const ULONGLONG>(bits.data(), (count + 63) / 64); }
+		};
+
+		template<class E, size_t N, class IsError = typename E::is_error> bool ok(const batch_result<E, N>& b) noexcept { return b.ok(); }
+
+		// codes || return_each<nt> - a batch_result for an array, vector or span of codes or errors, each failure is counted
+		template<class E, size_t N = MAXIMUM_WAIT_OBJECTS>
+		struct return_each_t
+		{
+			typedef void is_error_handler;
+
+			batch_result<E, N> operator()(std::span<const detail::raw_t<E>> raw) const noexcept {
+				batch_result<E, N> batch;
+				batch.assign(raw);
+				if (!batch.ok()) [[unlikely]] { count(batch); }
+				return batch;
+			}
+			batch_result<E, N> operator()(std::span<const E> errors) const noexcept {
+				batch_result<E, N> batch;
+				batch.assign(errors);
+				if (!batch.ok()) [[unlikely]] { count(batch); }
+				return batch;
+			}
+
+		private:
+			static __declspec(noinline) void count(const batch_result<E, N>& batch) noexcept {
+				batch.for_each_failure([](size_t, const E& e) { detail::count_failure(handler_id::return_each, E::error_domain, ULONG(e.value)); });
+			}
+		};
+		template<class E>
+		inline return_each_t<E> return_each{};
+	}
+}
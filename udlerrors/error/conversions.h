@@ -0,0 +1,110 @@
+#pragma once
+
+#include "win.h"
+#include "nt.h"
+#include "hr.h"
+
+#include <algorithm>
+#include <array>
+
+// NTSTATUS to win32 mappings that to_win() resolves at compile time
+// codes not listed here are translated by RtlNtStatusToDosError
+#define UDLERRORS_NT_TO_WIN_MAP(X) \
+	X(STATUS_SUCCESS, ERROR_SUCCESS) \
+	X(STATUS_PENDING, ERROR_IO_PENDING) \
+	X(STATUS_BUFFER_OVERFLOW, ERROR_MORE_DATA) \
+	X(STATUS_NO_MORE_FILES, ERROR_NO_MORE_FILES) \
+	X(STATUS_NO_MORE_ENTRIES, ERROR_NO_MORE_ITEMS) \
+	X(STATUS_UNSUCCESSFUL, ERROR_GEN_FAILURE) \
+	X(STATUS_NOT_IMPLEMENTED, ERROR_INVALID_FUNCTION) \
+	X(STATUS_INVALID_INFO_CLASS, ERROR_INVALID_PARAMETER) \
+	X(STATUS_INFO_LENGTH_MISMATCH, ERROR_BAD_LENGTH) \
+	X(STATUS_ACCESS_VIOLATION, ERROR_NOACCESS) \
+	X(STATUS_INVALID_HANDLE, ERROR_INVALID_HANDLE) \
+	X(STATUS_INVALID_PARAMETER, ERROR_INVALID_PARAMETER) \
+	X(STATUS_NO_SUCH_FILE, ERROR_FILE_NOT_FOUND) \
+	X(STATUS_INVALID_DEVICE_REQUEST, ERROR_INVALID_FUNCTION) \
+	X(STATUS_END_OF_FILE, ERROR_HANDLE_EOF) \
+	X(STATUS_NO_MEMORY, ERROR_NOT_ENOUGH_MEMORY) \
+	X(STATUS_ACCESS_DENIED, ERROR_ACCESS_DENIED) \
+	X(STATUS_BUFFER_TOO_SMALL, ERROR_INSUFFICIENT_BUFFER) \
+	X(STATUS_OBJECT_TYPE_MISMATCH, ERROR_INVALID_HANDLE) \
+	X(STATUS_OBJECT_NAME_INVALID, ERROR_INVALID_NAME) \
+	X(STATUS_OBJECT_NAME_NOT_FOUND, ERROR_FILE_NOT_FOUND) \
+	X(STATUS_OBJECT_NAME_COLLISION, ERROR_ALREADY_EXISTS) \
+	X(STATUS_OBJECT_PATH_NOT_FOUND, ERROR_PATH_NOT_FOUND) \
+	X(STATUS_SHARING_VIOLATION, ERROR_SHARING_VIOLATION) \
+	X(STATUS_FILE_LOCK_CONFLICT, ERROR_LOCK_VIOLATION) \
+	X(STATUS_LOCK_NOT_GRANTED, ERROR_LOCK_VIOLATION) \
+	X(STATUS_DELETE_PENDING, ERROR_ACCESS_DENIED) \
+	X(STATUS_PRIVILEGE_NOT_HELD, ERROR_PRIVILEGE_NOT_HELD) \
+	X(STATUS_DISK_FULL, ERROR_DISK_FULL) \
+	X(STATUS_INTEGER_OVERFLOW, ERROR_ARITHMETIC_OVERFLOW) \
+	X(STATUS_INSUFFICIENT_RESOURCES, ERROR_NO_SYSTEM_RESOURCES) \
+	X(STATUS_IO_TIMEOUT, ERROR_SEM_TIMEOUT) \
+	X(STATUS_FILE_IS_A_DIRECTORY, ERROR_ACCESS_DENIED) \
+	X(STATUS_NOT_SUPPORTED, ERROR_NOT_SUPPORTED) \
+	X(STATUS_INVALID_USER_BUFFER, ERROR_INVALID_USER_BUFFER) \
+	X(STATUS_DIRECTORY_NOT_EMPTY, ERROR_DIR_NOT_EMPTY) \
+	X(STATUS_NOT_A_DIRECTORY, ERROR_DIRECTORY) \
+	X(STATUS_CANCELLED, ERROR_OPERATION_ABORTED) \
+	X(STATUS_PIPE_BROKEN, ERROR_BROKEN_PIPE) \
+	X(STATUS_CONNECTION_RESET, ERROR_NETNAME_DELETED) \
+	X(STATUS_NOT_FOUND, ERROR_NOT_FOUND) \
+	X(STATUS_CONNECTION_REFUSED, ERROR_CONNECTION_REFUSED)
+
+#pragma comment(lib, "ntdll.lib")
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			struct nt_to_win_entry
+			{
+				ULONG nt;
+				DWORD win;
+			};
+
+#define UDLERRORS_ENTRY(NT, WIN) { ULONG(NT), DWORD(WIN) },
+			inline constexpr nt_to_win_entry nt_to_win_entries[] = { UDLERRORS_NT_TO_WIN_MAP(UDLERRORS_ENTRY) };
+#undef UDLERRORS_ENTRY
+
+			template<size_t N>
+			constexpr std::array<nt_to_win_entry, N> sort_nt_to_win(const nt_to_win_entry(&entries)[N]) {
+				std::array<nt_to_win_entry, N> table = {};
+				std::copy(entries, entries + N, table.begin());
+				std::sort(table.begin(), table.end(), [](const nt_to_win_entry& l, const nt_to_win_entry& r) { return l.nt < r.nt; });
+				return table;
+			}
+
+			inline constexpr auto nt_to_win_table = sort_nt_to_win(nt_to_win_entries);
+
+			// index of the entry for v, or nt_to_win_table.size()
+			constexpr size_t find_nt_to_win(NTSTATUS v) noexcept {
+				auto it = std::lower_bound(nt_to_win_table.begin(), nt_to_win_table.end(), ULONG(v), [](const nt_to_win_entry& e, ULONG nt) { return e.nt < nt; });
+				return (it != nt_to_win_table.end() && it->nt == ULONG(v)) ? size_t(it - nt_to_win_table.begin()) : nt_to_win_table.size();
+			}
+		}
+
+		constexpr hr to_hr(win e) noexcept {
+			return hr{ HRESULT(e.value) <= 0 ? HRESULT(e.value) : HRESULT((e.value & 0x0000FFFF) | (FACILITY_WIN32 << 16) | 0x80000000) };
+		}
+		constexpr hr to_hr(nt e) noexcept {
+			return hr{ HRESULT(ULONG(e.value) | FACILITY_NT_BIT) };
+		}
+		// only codes in UDLERRORS_NT_TO_WIN_MAP are constant expressions
+		constexpr win to_win(nt e) noexcept {
+			const size_t i = detail::find_nt_to_win(e.value);
+			return i != detail::nt_to_win_table.size() ? win{ detail::nt_to_win_table[i].win } : win{ RtlNtStatusToDosError(e.value) };
+		}
+	}
+}
+
+UDLERRORS_END_EXPORT
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(std::adjacent_find(detail::nt_to_win_table.begin(), detail::nt_to_win_table.end(), [](const detail::nt_to_win_entry& l, const detail::nt_to_win_entry& r) { return l.nt == r.nt; }) == detail::nt_to_win_table.end(), "UDLERRORS_NT_TO_WIN_MAP has a duplicate NTSTATUS");
+		static_assert(to_hr(0_win) == 0_hr && to_hr(5_win) == hr{ HRESULT(0x80070005) } && to_hr(nt{ STATUS_ACCESS_DENIED }) == hr{ HRESULT(0xD0000022) }, "to_hr must be constexpr");
+		static_assert(to_win(nt{ STATUS_ACCESS_DENIED }) == win{ ERROR_ACCESS_DENIED } && to_win(nt{ STATUS_PENDING }) == win{ ERROR_IO_PENDING } && to_win(0_nt) == 0_win, "to_win must be constexpr for mapped codes");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
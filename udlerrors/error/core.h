@@ -0,0 +1,505 @@
+#pragma once
+
+// the core of the library - unique_error, result, the check policies and error_exception
+// the domains are in error/win.h, error/nt.h and error/hr.h, what the handlers do with a failure is in error/hooks.h
+// udlerrors.h includes everything
+
+#include <windows.h>
+#include <intrin.h>
+
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstdlib>
+#include <cstring>
+#include <source_location>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if !defined(UDLERRORS_CHECKED)
+#if defined(NDEBUG)
+#define UDLERRORS_CHECKED 0
+#else
+#define UDLERRORS_CHECKED 1
+#endif
+#endif
+
+// UDLERRORS_EXCEPTIONS 0 for builds without exceptions (/EHs-c-)
+// the exception types are not defined and the throw_* handlers call the failure hook instead of throwing
+#if !defined(UDLERRORS_EXCEPTIONS)
+#if defined(_CPPUNWIND) || defined(__cpp_exceptions)
+#define UDLERRORS_EXCEPTIONS 1
+#else
+#define UDLERRORS_EXCEPTIONS 0
+#endif
+#endif
+
+#if UDLERRORS_EXCEPTIONS
+#include <exception>
+#endif
+
+// udlerrors.ixx wraps the headers in an export block and defines these to leave and reenter it
+// C++20 cannot export a static_assert or a specialization in namespace std, the headers close the block around them
+#if !defined(UDLERRORS_BEGIN_EXPORT)
+#define UDLERRORS_BEGIN_EXPORT
+#define UDLERRORS_END_EXPORT
+#endif
+
+namespace error {
+	inline namespace v0_1_0 {
+		// the source of an error value, each error type names its domain in T::error_domain
+		enum class domain : unsigned char { none, win, nt, hr };
+
+		constexpr const char* domain_name(domain d) noexcept {
+			return d == domain::win ? "win" : d == domain::nt ? "nt" : d == domain::hr ? "hr" : "none";
+		}
+
+		template<class T, class IsError = typename T::is_error> constexpr bool ok(const T& t) noexcept { return !!t; }
+
+		// the operators are found by ADL only, so they are not candidates for expressions that do not involve an error type
+		// the error types compare with hidden friends, != and the reversed forms are rewritten from ==
+		template<class T>
+		concept error_handler = requires { typename T::is_error_handler; };
+
+		template<class ReturnT, error_handler T>
+		constexpr auto operator||(const ReturnT& result, const T& handler) -> decltype(handler(result)) {
+			return handler(result);
+		}
+
+		// call site captured when a unique_error is given a value, kept only by policies that report it
+		struct no_call_site
+		{
+			constexpr no_call_site() noexcept {}
+			constexpr no_call_site(const std::source_location&) noexcept {}
+		};
+
+		// an error that was dropped without being checked, as kept by record_if_unchecked
+		struct unchecked_error
+		{
+			domain source;
+			ULONG code;
+			const char* file;
+			const char* function;
+			ULONG line;
+		};
+
+		namespace detail {
+			// fixed size ring of the most recent unchecked errors
+			// writers claim a slot with one fetch_add and publish it with a sequence number
+			class unchecked_log
+			{
+				static const size_t capacity = 256; // power of 2
+
+				struct entry
+				{
+					std::atomic<ULONGLONG> sequence;
+					std::atomic<domain> source;
+					std::atomic<ULONG> code;
+					std::atomic<ULONG> line;
+					std::atomic<const char*> file;
+					std::atomic<const char*> function;
+				};
+				entry entries[capacity];
+				std::atomic<ULONGLONG> next;
+
+			public:
+				void push(domain d, ULONG code, const std::source_location& where) noexcept {
+					const ULONGLONG n = next.fetch_add(1, std::memory_order_relaxed);
+					entry& slot = entries[n & (capacity - 1)];
+					slot.sequence.store(0, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_release);
+					slot.source.store(d, std::memory_order_relaxed);
+					slot.code.store(code, std::memory_order_relaxed);
+					slot.line.store(ULONG(where.line()), std::memory_order_relaxed);
+					slot.file.store(where.file_name(), std::memory_order_relaxed);
+					slot.function.store(where.function_name(), std::memory_order_relaxed);
+					slot.sequence.store(n + 1, std::memory_order_release);
+				}
+
+				// oldest first, entries that are being overwritten are skipped
+				size_t snapshot(unchecked_error* out, size_t size) const noexcept {
+					const ULONGLONG last = next.load(std::memory_order_acquire);
+					const ULONGLONG first = last > capacity ? last - capacity : 0;
+					size_t used = 0;
+					for (ULONGLONG n = first; n != last && used != size; ++n) {
+						const entry& slot = entries[n & (capacity - 1)];
+						if (slot.sequence.load(std::memory_order_acquire) != n + 1) {
+							continue;
+						}
+						out[used] = unchecked_error{
+							slot.source.load(std::memory_order_relaxed),
+							slot.code.load(std::memory_order_relaxed),
+							slot.file.load(std::memory_order_relaxed),
+							slot.function.load(std::memory_order_relaxed),
+							slot.line.load(std::memory_order_relaxed) };
+						std::atomic_thread_fence(std::memory_order_acquire);
+						if (slot.sequence.load(std::memory_order_relaxed) == n + 1) {
+							++used;
+						}
+					}
+					return used;
+				}
+			};
+
+			inline unchecked_log unchecked_errors;
+		}
+
+		// copies the most recent unchecked errors recorded by record_if_unchecked, oldest first
+		inline size_t unchecked_errors(unchecked_error* out, size_t size) noexcept { return detail::unchecked_errors.snapshot(out, size); }
+
+		// check policies for unique_error
+		// terminate_if_unchecked - terminate when an error is dropped without being checked or released
+		// fastfail_if_unchecked - __fastfail, no handlers run and a crash dump is taken
+		// record_if_unchecked - push the error and the call site that set it to unchecked_errors() and continue
+		// no_check - unique_error is a bare T, with trivial copy and destruction
+		// packed_check<P> - apply P, but keep the unchecked flag in a reserved bit of T::value (see packed_check_bit)
+		struct terminate_if_unchecked
+		{
+			static const bool checked = true;
+			typedef no_call_site call_site;
+
+			template<class T>
+#if UDLERRORS_EXCEPTIONS
+			static void unchecked(const T&, const call_site&) noexcept { std::terminate(); }
+#else
+			static void unchecked(const T&, const call_site&) noexcept { std::abort(); }
+#endif
+		};
+		struct fastfail_if_unchecked
+		{
+			static const bool checked = true;
+			typedef no_call_site call_site;
+
+			template<class T>
+			static void unchecked(const T&, const call_site&) noexcept { __fastfail(FAST_FAIL_FATAL_APP_EXIT); }
+		};
+		struct record_if_unchecked
+		{
+			static const bool checked = true;
+			struct call_site
+			{
+				std::source_location location;
+
+				call_site() noexcept {}
+				call_site(const std::source_location& l) noexcept : location(l) {}
+			};
+
+			template<class T>
+			static void unchecked(const T& e, const call_site& site) noexcept { detail::unchecked_errors.push(T::error_domain, ULONG(e.value), site.location); }
+		};
+		struct no_check
+		{
+			static const bool checked = false;
+			typedef no_call_site call_site;
+		};
+		template<class CheckPolicy>
+		struct packed_check : public CheckPolicy
+		{
+			static_assert(CheckPolicy::checked, "packed_check requires a checking policy");
+			static_assert(std::is_empty<typename CheckPolicy::call_site>::value, "packed_check cannot hold a call site");
+		};
+
+		// UDLERRORS_CHECK_POLICY names the policy used when checking is on, e.g. error::record_if_unchecked
+#if !defined(UDLERRORS_CHECK_POLICY)
+#define UDLERRORS_CHECK_POLICY terminate_if_unchecked
+#endif
+		typedef std::conditional<UDLERRORS_CHECKED != 0, UDLERRORS_CHECK_POLICY, no_check>::type default_check;
+
+		// specialize for error types that have a bit in value that is never set by a valid code
+		// mask - the bit used to mark the error unchecked
+		template<class T>
+		struct packed_check_bit
+		{
+			static const bool available = false;
+		};
+
+		// specialize for error types that have a code meaning the call was queued and completes later
+		// value - the in-flight code, e.g. ERROR_IO_PENDING
+		template<class T>
+		struct pending_status
+		{
+			static const bool available = false;
+		};
+
+		namespace detail {
+			enum class check_storage { none, flag, packed };
+
+			template<class CheckPolicy>
+			struct is_packed_check : public std::false_type {};
+			template<class CheckPolicy>
+			struct is_packed_check<packed_check<CheckPolicy>> : public std::true_type {};
+
+			template<class CheckPolicy>
+			struct select_check_storage : public std::integral_constant<check_storage,
+				!CheckPolicy::checked ? check_storage::none :
+				is_packed_check<CheckPolicy>::value ? check_storage::packed :
+				check_storage::flag> {};
+
+			template<class T, class CheckPolicy, check_storage Storage = select_check_storage<CheckPolicy>::value>
+			class unique_error_state;
+
+			template<class T, class CheckPolicy>
+			class unique_error_state<T, CheckPolicy, check_storage::flag> : private CheckPolicy::call_site
+			{
+				typedef typename CheckPolicy::call_site call_site;
+
+				T error;
+				mutable bool issafe;
+
+				const call_site& site() const noexcept { return *this; }
+
+			protected:
+				void safe_or_terminate() const { if (!issafe) { CheckPolicy::unchecked(error, site()); } }
+				void mark(bool safe) const noexcept { issafe = safe; }
+				void store(const T& e, bool safe, const call_site& s) noexcept { error = e; issafe = safe; call_site::operator=(s); }
+
+				~unique_error_state() { safe_or_terminate(); }
+
+				unique_error_state() noexcept : issafe(true) {}
+				template<class V>
+				unique_error_state(V v, const call_site& s) noexcept(std::is_nothrow_constructible<T, V>::value) : call_site(s), error(v), issafe(false) {}
+
+				// copy and move both hand the obligation to check over to the destination
+				unique_error_state(const unique_error_state& o) noexcept : call_site(o.site()), error(o.error), issafe(o.issafe) { o.issafe = true; }
+				unique_error_state(unique_error_state&& o) noexcept : call_site(o.site()), error(std::move(o.error)), issafe(o.issafe) { o.issafe = true; }
+
+				// assigning over an unchecked error drops it
+				unique_error_state& operator=(const unique_error_state& o) noexcept { if (this != &o) { safe_or_terminate(); store(o.error, o.issafe, o.site()); o.issafe = true; } return *this; }
+				unique_error_state& operator=(unique_error_state&& o) noexcept { if (this != &o) { safe_or_terminate(); store(std::move(o.error), o.issafe, o.site()); o.issafe = true; } return *this; }
+
+			public:
+				T& get() noexcept { return error; }
+				const T& get() const noexcept { return error; }
+
+				bool is_safe() const noexcept { return issafe; }
+			};
+
+			template<class T, class CheckPolicy>
+			class unique_error_state<T, CheckPolicy, check_storage::packed>
+			{
+				typedef packed_check_bit<T> bit;
+				typedef typename CheckPolicy::call_site call_site;
+				typedef typename std::remove_cv<decltype(std::declval<T&>().value)>::type value_type;
+				static_assert(bit::available, "packed_check requires a packed_check_bit<T> specialization");
+				static_assert(sizeof(value_type) == sizeof(ULONG), "packed_check requires a 32bit value");
+
+				mutable T error;
+
+				static value_type with(value_type v, bool safe) noexcept { return value_type(safe ? (ULONG(v) & ~ULONG(bit::mask)) : (ULONG(v) | ULONG(bit::mask))); }
+
+			protected:
+				void safe_or_terminate() const { if (!is_safe()) { CheckPolicy::unchecked(get(), call_site{}); } }
+				void mark(bool safe) const noexcept { error.value = with(error.value, safe); }
+				void store(const T& e, bool safe, const call_site&) noexcept { assert(ULONG(e.value) == ULONG(with(e.value, true))); error = e; mark(safe); }
+
+				~unique_error_state() { safe_or_terminate(); }
+
+				unique_error_state() noexcept {}
+				template<class V>
+				unique_error_state(V v, const call_site&) noexcept(std::is_nothrow_constructible<T, V>::value) : error(v) { assert(ULONG(error.value) == ULONG(with(error.value, true))); mark(false); }
+
+				unique_error_state(const unique_error_state& o) noexcept : error(o.error) { o.mark(true); }
+				unique_error_state(unique_error_state&& o) noexcept : error(o.error) { o.mark(true); }
+
+				unique_error_state& operator=(const unique_error_state& o) noexcept { if (this != &o) { safe_or_terminate(); error = o.error; o.mark(true); } return *this; }
+				unique_error_state& operator=(unique_error_state&& o) noexcept { if (this != &o) { safe_or_terminate(); error = o.error; o.mark(true); } return *this; }
+
+			public:
+				// the stored value carries the flag, so get() returns a copy without it
+				T get() const noexcept { T result = error; result.value = with(result.value, true); return result; }
+
+				bool is_safe() const noexcept { return ULONG(error.value) == ULONG(with(error.value, true)); }
+			};
+
+			template<class T, class CheckPolicy>
+			class unique_error_state<T, CheckPolicy, check_storage::none>
+			{
+				typedef typename CheckPolicy::call_site call_site;
+
+				T error;
+
+			protected:
+				void safe_or_terminate() const noexcept {}
+				void mark(bool) const noexcept {}
+				void store(const T& e, bool, const call_site&) noexcept { error = e; }
+
+				unique_error_state() noexcept {}
+				template<class V>
+				unique_error_state(V v, const call_site&) noexcept(std::is_nothrow_constructible<T, V>::value) : error(v) {}
+
+			public:
+				T& get() noexcept { return error; }
+				const T& get() const noexcept { return error; }
+
+				bool is_safe() const noexcept { return true; }
+			};
+		}
+
+		template<class T, class CheckPolicy = default_check, class IsError = typename T::is_error>
+		class unique_error : public detail::unique_error_state<T, CheckPolicy>
+		{
+			typedef detail::unique_error_state<T, CheckPolicy> state;
+			typedef typename CheckPolicy::call_site call_site;
+
+		public:
+			unique_error() noexcept {}
+			template<class V>
+			unique_error(V v, const std::source_location& where = std::source_location::current()) noexcept(std::is_nothrow_constructible<T, V>::value) : state(v, call_site{ where }) {}
+
+			bool ok() const noexcept { state::mark(true);  return error::ok(state::get()); }
+			explicit operator bool() const noexcept { return ok(); }
+
+			unique_error& reset() { state::safe_or_terminate(); state::store(T{}, true, call_site{}); return *this; }
+			template<class V>
+			unique_error& reset(V v, const std::source_location& where = std::source_location::current()) { state::safe_or_terminate(); state::store(T{v}, false, call_site{ where }); return *this; }
+
+			T release() noexcept { T result = state::get(); state::store(T{}, true, call_site{}); return result; }
+
+			// exact types only, so a raw code is not converted to an unchecked unique_error to compare it
+			friend bool operator==(const std::same_as<unique_error> auto& lhs, const std::same_as<T> auto& rhs) noexcept { return lhs.get().value == rhs.value; }
+			friend bool operator==(const std::same_as<unique_error> auto& lhs, const std::same_as<unique_error> auto& rhs) noexcept { return lhs.get().value == rhs.get().value; }
+		};
+
+		template<class T, class CheckPolicy, class IsError = typename T::is_error> bool ok(const unique_error<T, CheckPolicy>& t) noexcept { return t.ok(); }
+
+		// result<T, E> - the error and the value returned by a call
+		// value() is whatever the call returned, even when the error is not ok
+		// an aggregate built with braces, result<T, E>{ e, v }, with public members and no constructors
+		// so that the x64 convention returns it in RAX when it fits in 8 bytes, win, nt and hr are aggregates for the same reason
+		template<class T, class E, class IsError = typename E::is_error>
+		struct [[nodiscard]] result
+		{
+			typedef T value_type;
+			typedef E error_type;
+
+			E err{};
+			T val{};
+
+			constexpr bool ok() const noexcept { return error::ok(err); }
+			constexpr explicit operator bool() const noexcept { return ok(); }
+
+			constexpr const E& error() const noexcept { return err; }
+			constexpr const T& value() const noexcept { return val; }
+
+			template<class U>
+			T value_or(U&& u) const { return ok() ? val : static_cast<T>(std::forward<U>(u)); }
+
+			// f(value()) must return a result<U, E>
+			template<class F>
+			auto and_then(F f) const -> decltype(f(std::declval<const T&>())) {
+				typedef decltype(f(val)) next;
+				return ok() ? f(val) : next{ err };
+			}
+
+			// f(error()) must return a result<T, E>
+			template<class F>
+			result or_else(F f) const { return ok() ? *this : f(err); }
+		};
+
+		template<class E, class IsError>
+		struct [[nodiscard]] result<void, E, IsError>
+		{
+			typedef void value_type;
+			typedef E error_type;
+
+			E err{};
+
+			constexpr bool ok() const noexcept { return error::ok(err); }
+			constexpr explicit operator bool() const noexcept { return ok(); }
+
+			constexpr const E& error() const noexcept { return err; }
+
+			// f() must return a result<U, E>
+			template<class F>
+			auto and_then(F f) const -> decltype(f()) {
+				typedef decltype(f()) next;
+				return ok() ? f() : next{ err };
+			}
+
+			// f(error()) must return a result<void, E>
+			template<class F>
+			result or_else(F f) const { return ok() ? *this : f(err); }
+		};
+
+		template<class T, class E, class IsError = typename E::is_error> constexpr bool ok(const result<T, E>& r) noexcept { return r.ok(); }
+
+		// the three outcomes of starting an overlapped call
+		enum class completion : unsigned char { completed, pending, failed };
+
+		// pending_result<T, E> - result<T, E> for calls that may complete later, e.g. through an IOCP
+		// the in-flight code (pending_status<E>) is neither a failure nor a completion, ok() is true for both
+		// an aggregate like result
+		template<class T, class E, class IsError = typename E::is_error>
+		struct [[nodiscard]] pending_result
+		{
+			typedef T value_type;
+			typedef E error_type;
+
+			E err{};
+			T val{};
+
+			constexpr bool pending() const noexcept { static_assert(pending_status<E>::available, "pending_result requires a pending_status<E> specialization"); return ULONG(err.value) == ULONG(pending_status<E>::value); }
+			constexpr bool completed() const noexcept { return !pending() && error::ok(err); }
+			constexpr bool failed() const noexcept { return !pending() && !error::ok(err); }
+			constexpr completion state() const noexcept { return pending() ? completion::pending : error::ok(err) ? completion::completed : completion::failed; }
+
+			constexpr bool ok() const noexcept { return !failed(); }
+			constexpr explicit operator bool() const noexcept { return ok(); }
+
+			constexpr const E& error() const noexcept { return err; }
+			constexpr const T& value() const noexcept { return val; }
+		};
+
+		template<class E, class IsError>
+		struct [[nodiscard]] pending_result<void, E, IsError>
+		{
+			typedef void value_type;
+			typedef E error_type;
+
+			E err{};
+
+			constexpr bool pending() const noexcept { static_assert(pending_status<E>::available, "pending_result requires a pending_status<E> specialization"); return ULONG(err.value) == ULONG(pending_status<E>::value); }
+			constexpr bool completed() const noexcept { return !pending() && error::ok(err); }
+			constexpr bool failed() const noexcept { return !pending() && !error::ok(err); }
+			constexpr completion state() const noexcept { return pending() ? completion::pending : error::ok(err) ? completion::completed : completion::failed; }
+
+			constexpr bool ok() const noexcept { return !failed(); }
+			constexpr explicit operator bool() const noexcept { return ok(); }
+
+			constexpr const E& error() const noexcept { return err; }
+		};
+
+		template<class T, class E, class IsError = typename E::is_error> constexpr bool ok(const pending_result<T, E>& r) noexcept { return r.ok(); }
+
+#if UDLERRORS_EXCEPTIONS
+		// what() is formatted on first use into an inline buffer - "<domain> 0x<code>: <message>"
+		// nothing is allocated when the exception is thrown or when what() is called
+		struct error_exception : public std::exception
+		{
+			bool isok;
+
+			template<class T, class IsError = typename T::is_error> explicit error_exception(const T& e) noexcept
+				: isok(error::ok(e)), source(T::error_domain), code(ULONG(e.value)), formatted(false) { text[0] = '\0'; }
+
+			bool ok() const noexcept { return isok; }
+			explicit operator bool() const noexcept { return ok(); }
+
+			const char* what() const noexcept override;
+
+		protected:
+			// formats "<domain> 0x<code>: <description>" once, an empty description leaves out the ": "
+			const char* format(std::wstring_view description) const noexcept;
+			bool is_formatted() const noexcept { return formatted; }
+
+		private:
+			static const size_t max_text = 128;
+
+			domain source;
+			ULONG code;
+			mutable bool formatted;
+			mutable char text[max_text];
+		};
+#endif
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "core.h"
+
+#if !defined(UDLERRORS_COUNTERS)
+#define UDLERRORS_COUNTERS 0
+#endif
+
+#if UDLERRORS_COUNTERS
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+#endif
+
+namespace error {
+	inline namespace v0_1_0 {
+		// the handler that saw a failure, for the failure counters
+		enum class handler_id : unsigned char { last_error_if, throw_last_error_if, throw_nt, return_nt, throw_hr, return_hr, pending_ok_if, pending_ok_nt, make_handle_or_error, retry_if, return_each };
+
+		inline const char* handler_name(handler_id h) noexcept {
+			static const char* const names[] = { "last_error_if", "throw_last_error_if", "throw_nt", "return_nt", "throw_hr", "return_hr", "pending_ok_if", "pending_ok_nt", "make_handle_or_error", "retry_if", "return_each" };
+			return size_t(h) < sizeof(names) / sizeof(names[0]) ? names[size_t(h)] : "unknown";
+		}
+
+		struct failure_count
+		{
+			handler_id handler;
+			domain source;
+			ULONG code;
+			ULONGLONG count;
+		};
+
+#if UDLERRORS_COUNTERS
+		namespace detail {
+			// each thread counts into its own cache aligned shard, shards are only summed by failure_counts()
+			class failure_counters
+			{
+				static const size_t max_shards = 64;
+				static const size_t slots_per_shard = 128; // power of 2
+
+				struct slot
+				{
+					std::atomic<ULONGLONG> key;
+					std::atomic<ULONGLONG> count;
+				};
+				struct alignas(64) shard
+				{
+					slot slots[slots_per_shard];
+					std::atomic<ULONGLONG> dropped;
+				};
+
+				shard shards[max_shards];
+				std::atomic<size_t> threads;
+
+				static constexpr ULONGLONG make_key(handler_id h, domain d, ULONG code) noexcept { return ((ULONGLONG(h) + 1) << 40) | (ULONGLONG(d) << 32) | code; }
+				static size_t hash(ULONGLONG key) noexcept { return size_t((key * 0x9E3779B97F4A7C15ull) >> 40) & (slots_per_shard - 1); }
+
+				shard& this_thread_shard() noexcept {
+					// threads past max_shards share, the relaxed increments keep shared shards exact
+					thread_local shard& mine = shards[threads.fetch_add(1, std::memory_order_relaxed) % max_shards];
+					return mine;
+				}
+
+			public:
+				void count(handler_id h, domain d, ULONG code) noexcept {
+					const ULONGLONG key = make_key(h, d, code);
+					shard& s = this_thread_shard();
+					size_t i = hash(key);
+					for (size_t probe = 0; probe != slots_per_shard; ++probe, i = (i + 1) & (slots_per_shard - 1)) {
+						ULONGLONG current = s.slots[i].key.load(std::memory_order_relaxed);
+						if (current == 0 && s.slots[i].key.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+							current = key;
+						}
+						if (current == key) {
+							s.slots[i].count.fetch_add(1, std::memory_order_relaxed);
+							return;
+						}
+					}
+					s.dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				size_t snapshot(failure_count* out, size_t capacity) const noexcept {
+					size_t used = 0;
+					for (const shard& s : shards) {
+						for (const slot& sl : s.slots) {
+							const ULONGLONG key = sl.key.load(std::memory_order_relaxed);
+							const ULONGLONG count = sl.count.load(std::memory_order_relaxed);
+							if (key == 0 || count == 0) {
+								continue;
+							}
+							const failure_count entry = { handler_id((key >> 40) - 1), domain((key >> 32) & 0xFF), ULONG(key), count };
+							size_t i = 0;
+							while (i != used && !(out[i].handler == entry.handler && out[i].source == entry.source && out[i].code == entry.code)) { ++i; }
+							if (i != used) {
+								out[i].count += count;
+							}
+							else if (used != capacity) {
+								out[used++] = entry;
+							}
+						}
+					}
+					return used;
+				}
+
+				ULONGLONG dropped() const noexcept {
+					ULONGLONG total = 0;
+					for (const shard& s : shards) { total += s.dropped.load(std::memory_order_relaxed); }
+					return total;
+				}
+			};
+
+			inline failure_counters counters;
+		}
+
+		// sums the per thread counters into out, returns the number of entries written
+		inline size_t failure_counts(failure_count* out, size_t capacity) noexcept { return detail::counters.snapshot(out, capacity); }
+
+		// failures that were not counted by code because a shard was full
+		inline ULONGLONG failure_counts_dropped() noexcept { return detail::counters.dropped(); }
+
+		// writes one "ErrorFailureCount" event per entry to a provider registered by the caller
+		inline void trace_failure_counts(TraceLoggingHProvider provider) noexcept {
+			failure_count counts[256];
+			size_t used = failure_counts(counts, 256);
+			for (size_t i = 0; i != used; ++i) {
+				TraceLoggingWrite(provider, "ErrorFailureCount",
+					TraceLoggingString(handler_name(counts[i].handler), "Handler"),
+					TraceLoggingString(domain_name(counts[i].source), "Domain"),
+					TraceLoggingHexUInt32(counts[i].code, "Code"),
+					TraceLoggingUInt64(counts[i].count, "Count"));
+			}
+		}
+#else
+		inline size_t failure_counts(failure_count*, size_t) noexcept { return 0; }
+		inline ULONGLONG failure_counts_dropped() noexcept { return 0; }
+#endif
+	}
+}
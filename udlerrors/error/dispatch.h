@@ -0,0 +1,163 @@
+#pragma once
+
+#include "core.h"
+#include "nt.h"
+#include "hr.h"
+
+#include <array>
+
+namespace error {
+	inline namespace v0_1_0 {
+		// the two severity bits of an NTSTATUS, an HRESULT is success or error
+		enum class severity : unsigned char { success, information, warning, error };
+
+		template<class E>
+		struct dispatch_traits;
+
+		// HRESULT - 11 bits of facility below the N and X bits, so an HRESULT_FROM_NT value keeps the NT facility bits
+		template<>
+		struct dispatch_traits<hr>
+		{
+			static const size_t facilities = 0x800;
+			static constexpr USHORT facility(ULONG v) noexcept { return USHORT((v >> 16) & 0x7FF); }
+			static constexpr severity severity_of(ULONG v) noexcept { return (v >> 31) != 0 ? severity::error : severity::success; }
+		};
+		// NTSTATUS - 12 bits of facility below the customer bit and the two severity bits
+		template<>
+		struct dispatch_traits<nt>
+		{
+			static const size_t facilities = 0x1000;
+			static constexpr USHORT facility(ULONG v) noexcept { return USHORT((v >> 16) & 0xFFF); }
+			static constexpr severity severity_of(ULONG v) noexcept { return severity(v >> 30); }
+		};
+
+		template<class R>
+		struct dispatch_rule
+		{
+			enum class kind : unsigned char { codes, facility, severity };
+
+			kind applies_to;
+			USHORT facility;
+			USHORT low;
+			USHORT high;
+			severity group;
+			R result;
+		};
+
+		template<class E, class R, size_t N>
+		class dispatch_table;
+
+		// dispatch<E, R>(otherwise).codes(...).facility(...).severity(...).compile() builds a dispatch_table at compile time
+		// the table maps an error to an R - a decision is a lookup, R can be a function pointer to call handlers instead
+		// the most specific rule wins - a code range, then its facility, then its severity, then otherwise
+		// the first rule registered wins when code ranges overlap
+		template<class E, class R, size_t N = 0>
+		class dispatch
+		{
+		public:
+			typedef dispatch_rule<R> rule;
+
+			constexpr explicit dispatch(R otherwise) noexcept : otherwise(otherwise), rules{} {}
+			constexpr dispatch(R otherwise, const std::array<rule, N>& rules) noexcept : otherwise(otherwise), rules(rules) {}
+
+			constexpr dispatch<E, R, N + 1> codes(USHORT f, USHORT low, USHORT high, R r) const noexcept { return add({ rule::kind::codes, f, low, high, severity::success, r }); }
+			constexpr dispatch<E, R, N + 1> code(USHORT f, USHORT c, R r) const noexcept { return add({ rule::kind::codes, f, c, c, severity::success, r }); }
+			constexpr dispatch<E, R, N + 1> facility(USHORT f, R r) const noexcept { return add({ rule::kind::facility, f, 0, 0, severity::success, r }); }
+			constexpr dispatch<E, R, N + 1> severity(error::severity s, R r) const noexcept { return add({ rule::kind::severity, 0, 0, 0, s, r }); }
+
+			constexpr dispatch_table<E, R, N> compile() const noexcept { return dispatch_table<E, R, N>(otherwise, rules); }
+
+		private:
+			constexpr dispatch<E, R, N + 1> add(const rule& r) const noexcept {
+				static_assert(N < 0xFF, "a dispatch holds at most 255 rules");
+				std::array<rule, N + 1> more = {};
+				for (size_t i = 0; i != N; ++i) {
+					more[i] = rules[i];
+				}
+				more[N] = r;
+				return dispatch<E, R, N + 1>(otherwise, more);
+			}
+
+			R otherwise;
+			std::array<rule, N> rules;
+		};
+
+		// one byte per facility selects a slot, a slot holds the facility result and the code ranges of that facility
+		// a lookup is two loads and the scan of the ranges registered for the one facility
+		template<class E, class R, size_t N>
+		class dispatch_table
+		{
+		public:
+			typedef dispatch_traits<E> traits;
+
+			constexpr dispatch_table(R otherwise, const std::array<dispatch_rule<R>, N>& rules) noexcept
+				: slot_of{}, slots{}, ranges{}, by_severity{}, results{} {
+				typedef typename dispatch_rule<R>::kind kind;
+				results[N] = otherwise;
+				for (auto& s : by_severity) { s = N; }
+				slots[0] = { N, 0, 0 };
+				unsigned char used = 1;
+				unsigned char next_range = 0;
+				for (size_t i = 0; i != N; ++i) {
+					results[i] = rules[i].result;
+					if (rules[i].applies_to == kind::severity) {
+						if (by_severity[size_t(rules[i].group)] == N) { by_severity[size_t(rules[i].group)] = (unsigned char)(i); }
+						continue;
+					}
+					const USHORT f = USHORT(rules[i].facility % traits::facilities);
+					if (slot_of[f] != 0) {
+						continue;
+					}
+					// the first rule for a facility claims a slot and gathers every range for it, in registration order
+					slot& s = slots[used];
+					slot_of[f] = used++;
+					s = { N, next_range, next_range };
+					for (size_t j = i; j != N; ++j) {
+						if (rules[j].applies_to == kind::severity || USHORT(rules[j].facility % traits::facilities) != f) {
+							continue;
+						}
+						if (rules[j].applies_to == kind::facility) {
+							if (s.result == N) { s.result = (unsigned char)(j); }
+						}
+						else {
+							ranges[next_range++] = { rules[j].low, rules[j].high, (unsigned char)(j) };
+						}
+					}
+					s.last = next_range;
+				}
+			}
+
+			constexpr R operator()(E e) const noexcept {
+				const ULONG v = ULONG(e.value);
+				const slot& s = slots[slot_of[traits::facility(v)]];
+				const USHORT code = USHORT(v & 0xFFFF);
+				for (unsigned char i = s.first; i != s.last; ++i) {
+					if (code >= ranges[i].low && code <= ranges[i].high) {
+						return results[ranges[i].result];
+					}
+				}
+				return results[s.result != N ? s.result : by_severity[size_t(traits::severity_of(v))]];
+			}
+
+		private:
+			struct slot
+			{
+				unsigned char result;
+				unsigned char first;
+				unsigned char last;
+			};
+			struct range
+			{
+				USHORT low;
+				USHORT high;
+				unsigned char result;
+			};
+
+			std::array<unsigned char, traits::facilities> slot_of;
+			std::array<slot, N + 1> slots;
+			std::array<range, N> ranges;
+			std::array<unsigned char, 4> by_severity;
+			std::array<R, N + 1> results;
+		};
+	}
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "conversions.h"
+
+#include <array>
+#include <string>
+#include <system_error>
+
+// win32 codes that have a portable std::errc condition, the same mapping as the msvc system_category()
+#define UDLERRORS_WIN_TO_ERRC_MAP(X) \
+	X(ERROR_INVALID_FUNCTION, function_not_supported) \
+	X(ERROR_FILE_NOT_FOUND, no_such_file_or_directory) \
+	X(ERROR_PATH_NOT_FOUND, no_such_file_or_directory) \
+	X(ERROR_TOO_MANY_OPEN_FILES, too_many_files_open) \
+	X(ERROR_ACCESS_DENIED, permission_denied) \
+	X(ERROR_INVALID_HANDLE, invalid_argument) \
+	X(ERROR_NOT_ENOUGH_MEMORY, not_enough_memory) \
+	X(ERROR_INVALID_ACCESS, permission_denied) \
+	X(ERROR_OUTOFMEMORY, not_enough_memory) \
+	X(ERROR_INVALID_DRIVE, no_such_device) \
+	X(ERROR_CURRENT_DIRECTORY, permission_denied) \
+	X(ERROR_NOT_SAME_DEVICE, cross_device_link) \
+	X(ERROR_WRITE_PROTECT, permission_denied) \
+	X(ERROR_BAD_UNIT, no_such_device) \
+	X(ERROR_NOT_READY, resource_unavailable_try_again) \
+	X(ERROR_SEEK, io_error) \
+	X(ERROR_WRITE_FAULT, io_error) \
+	X(ERROR_READ_FAULT, io_error) \
+	X(ERROR_SHARING_VIOLATION, permission_denied) \
+	X(ERROR_LOCK_VIOLATION, no_lock_available) \
+	X(ERROR_HANDLE_DISK_FULL, no_space_on_device) \
+	X(ERROR_NOT_SUPPORTED, not_supported) \
+	X(ERROR_DEV_NOT_EXIST, no_such_device) \
+	X(ERROR_FILE_EXISTS, file_exists) \
+	X(ERROR_CANNOT_MAKE, permission_denied) \
+	X(ERROR_INVALID_PARAMETER, invalid_argument) \
+	X(ERROR_OPEN_FAILED, io_error) \
+	X(ERROR_BUFFER_OVERFLOW, filename_too_long) \
+	X(ERROR_DISK_FULL, no_space_on_device) \
+	X(ERROR_INVALID_NAME, no_such_file_or_directory) \
+	X(ERROR_NEGATIVE_SEEK, invalid_argument) \
+	X(ERROR_BUSY_DRIVE, device_or_resource_busy) \
+	X(ERROR_DIR_NOT_EMPTY, directory_not_empty) \
+	X(ERROR_BUSY, device_or_resource_busy) \
+	X(ERROR_ALREADY_EXISTS, file_exists) \
+	X(ERROR_LOCKED, no_lock_available) \
+	X(ERROR_DIRECTORY, invalid_argument) \
+	X(ERROR_OPERATION_ABORTED, operation_canceled) \
+	X(ERROR_NOACCESS, permission_denied) \
+	X(ERROR_CANTOPEN, io_error) \
+	X(ERROR_CANTREAD, io_error) \
+	X(ERROR_CANTWRITE, io_error) \
+	X(ERROR_RETRY, resource_unavailable_try_again) \
+	X(ERROR_OPEN_FILES, device_or_resource_busy) \
+	X(ERROR_DEVICE_IN_USE, device_or_resource_busy) \
+	X(ERROR_REPARSE_TAG_INVALID, invalid_argument)
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			struct win_to_errc_entry
+			{
+				DWORD win;
+				std::errc errc;
+			};
+
+#define UDLERRORS_ENTRY(WIN, ERRC) { DWORD(WIN), std::errc::ERRC },
+			inline constexpr win_to_errc_entry win_to_errc_entries[] = { UDLERRORS_WIN_TO_ERRC_MAP(UDLERRORS_ENTRY) };
+#undef UDLERRORS_ENTRY
+
+			template<size_t N>
+			constexpr std::array<win_to_errc_entry, N> sort_win_to_errc(const win_to_errc_entry(&entries)[N]) {
+				std::array<win_to_errc_entry, N> table = {};
+				std::copy(entries, entries + N, table.begin());
+				std::sort(table.begin(), table.end(), [](const win_to_errc_entry& l, const win_to_errc_entry& r) { return l.win < r.win; });
+				return table;
+			}
+
+			inline constexpr auto win_to_errc_table = sort_win_to_errc(win_to_errc_entries);
+
+			// the win32 code that a value stands for, ERROR_MR_MID_NOT_FOUND when it has none
+			constexpr DWORD win_form(domain d, ULONG v) noexcept {
+				switch (d) {
+				case domain::win: return DWORD(v);
+				case domain::nt: return to_win(nt{ NTSTATUS(v) }).value;
+				case domain::hr:
+					if (v == ULONG(S_OK)) { return ERROR_SUCCESS; }
+					if ((v & ULONG(FACILITY_NT_BIT)) != 0) { return to_win(nt{ NTSTATUS(v & ~ULONG(FACILITY_NT_BIT)) }).value; }
+					if (LONG(v) < 0 && HRESULT_FACILITY(v) == FACILITY_WIN32) { return DWORD(HRESULT_CODE(v)); }
+					return ERROR_MR_MID_NOT_FOUND;
+				default: return ERROR_MR_MID_NOT_FOUND;
+				}
+			}
+		}
+
+		// the portable condition for an error, std::errc{} for success and for codes that have none
+		constexpr std::errc to_errc(win e) noexcept {
+			auto it = std::lower_bound(detail::win_to_errc_table.begin(), detail::win_to_errc_table.end(), e.value, [](const detail::win_to_errc_entry& l, DWORD w) { return l.win < w; });
+			return (it != detail::win_to_errc_table.end() && it->win == e.value) ? it->errc : std::errc{};
+		}
+		// only codes in UDLERRORS_NT_TO_WIN_MAP are constant expressions
+		constexpr std::errc to_errc(nt e) noexcept {
+			return to_errc(to_win(e));
+		}
+		constexpr std::errc to_errc(hr e) noexcept {
+			switch (e.value) {
+			case E_NOTIMPL: return std::errc::function_not_supported;
+			case E_POINTER: return std::errc::invalid_argument;
+			case E_ABORT: return std::errc::operation_canceled;
+			}
+			const DWORD w = detail::win_form(domain::hr, ULONG(e.value));
+			return w != ERROR_MR_MID_NOT_FOUND ? to_errc(win{ w }) : std::errc{};
+		}
+
+		namespace detail {
+			// the FormatMessage text, as for message(), in utf-8
+			template<class T>
+			std::string narrow_message(const T& e) {
+				wchar_t wide[512];
+				const int length = int(error::message(e, wide, 512));
+				std::string text(size_t(length == 0 ? 0 : WideCharToMultiByte(CP_UTF8, 0, wide, length, nullptr, 0, nullptr, nullptr)), '\0');
+				if (!text.empty()) {
+					WideCharToMultiByte(CP_UTF8, 0, wide, length, text.data(), int(text.size()), nullptr, nullptr);
+				}
+				return text;
+			}
+
+			// the domain of a std::error_code, win for the msvc system_category() and none for other categories
+			inline domain code_domain(const std::error_category& c) noexcept;
+
+			// the same error when in the same domain with the same value, or when both stand for the same win32 code
+			inline bool equivalent(domain d, ULONG v, const std::error_code& code) noexcept {
+				const domain other = code_domain(code.category());
+				if (other == domain::none) {
+					return false;
+				}
+				if (other == d) {
+					return ULONG(code.value()) == v;
+				}
+				const DWORD w = win_form(d, v);
+				return w != ERROR_MR_MID_NOT_FOUND && w == win_form(other, ULONG(code.value()));
+			}
+
+			template<class T>
+			class error_category_t final : public std::error_category
+			{
+				typedef decltype(T{}.value) value_type;
+
+			public:
+				const char* name() const noexcept override { return domain_name(T::error_domain); }
+				std::string message(int code) const override { return narrow_message(T{ value_type(code) }); }
+
+				std::error_condition default_error_condition(int code) const noexcept override {
+					const std::errc c = to_errc(T{ value_type(code) });
+					return c != std::errc{} ? std::make_error_condition(c) : std::error_condition(code, *this);
+				}
+				bool equivalent(const std::error_code& code, int condition) const noexcept override {
+					return detail::equivalent(T::error_domain, ULONG(condition), code);
+				}
+			};
+
+			// msvc's std::error_category constructor is not constexpr, so the categories are function local statics
+			// the fast path below only compares category addresses, which does not need constant initialization
+			template<class T>
+			const std::error_category& category_instance() noexcept {
+				static const error_category_t<T> instance;
+				return instance;
+			}
+		}
+
+		inline const std::error_category& win_category() noexcept { return detail::category_instance<win>(); }
+		inline const std::error_category& nt_category() noexcept { return detail::category_instance<nt>(); }
+		inline const std::error_category& hr_category() noexcept { return detail::category_instance<hr>(); }
+
+		template<class T> const std::error_category& category_of() noexcept;
+		template<> inline const std::error_category& category_of<win>() noexcept { return win_category(); }
+		template<> inline const std::error_category& category_of<nt>() noexcept { return nt_category(); }
+		template<> inline const std::error_category& category_of<hr>() noexcept { return hr_category(); }
+
+		namespace detail {
+			inline domain code_domain(const std::error_category& c) noexcept {
+				return c == win_category() || c == std::system_category() ? domain::win : c == nt_category() ? domain::nt : c == hr_category() ? domain::hr : domain::none;
+			}
+		}
+
+		// found by std::error_code, so std::error_code ec = hr{ E_FAIL }; works - nothing is allocated
+		inline std::error_code make_error_code(win e) noexcept { return std::error_code(int(e.value), win_category()); }
+		inline std::error_code make_error_code(nt e) noexcept { return std::error_code(int(e.value), nt_category()); }
+		inline std::error_code make_error_code(hr e) noexcept { return std::error_code(int(e.value), hr_category()); }
+
+		namespace detail {
+			// a code from another category, not the comparison that the caller is expected to make
+			__declspec(noinline) inline bool equal_code(domain d, ULONG v, const std::error_code& code, const std::error_category& category) noexcept {
+				if (code_domain(code.category()) != domain::none) {
+					return equivalent(d, v, code);
+				}
+				return code == std::error_condition(int(v), category);
+			}
+		}
+
+		// the same category compares the values inline, the library's other domains compare through win_form()
+		// only codes from other categories go through the virtual std::error_category::equivalent()
+		template<class T, class IsError = typename T::is_error>
+		bool operator==(const T& lhs, const std::error_code& rhs) noexcept {
+			if (rhs.category() == category_of<T>()) {
+				return ULONG(rhs.value()) == ULONG(lhs.value);
+			}
+			return detail::equal_code(T::error_domain, ULONG(lhs.value), rhs, category_of<T>());
+		}
+
+		template<class T, class IsError = typename T::is_error>
+		constexpr bool operator==(const T& lhs, std::errc rhs) noexcept {
+			return to_errc(lhs) == rhs;
+		}
+	}
+}
+
+UDLERRORS_END_EXPORT
+namespace std {
+	template<> struct is_error_code_enum<error::win> : true_type {};
+	template<> struct is_error_code_enum<error::nt> : true_type {};
+	template<> struct is_error_code_enum<error::hr> : true_type {};
+}
+
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(std::adjacent_find(detail::win_to_errc_table.begin(), detail::win_to_errc_table.end(), [](const detail::win_to_errc_entry& l, const detail::win_to_errc_entry& r) { return l.win == r.win; }) == detail::win_to_errc_table.end(), "UDLERRORS_WIN_TO_ERRC_MAP has a duplicate code");
+		static_assert(to_errc(win{ ERROR_ACCESS_DENIED }) == std::errc::permission_denied && to_errc(0_win) == std::errc{} && to_errc(win{ ERROR_IO_PENDING }) == std::errc{}, "to_errc(win) must be constexpr");
+		static_assert(to_errc(nt{ STATUS_OBJECT_NAME_NOT_FOUND }) == std::errc::no_such_file_or_directory && to_errc(hr{ E_INVALIDARG }) == std::errc::invalid_argument && to_errc(hr{ E_NOTIMPL }) == std::errc::function_not_supported, "to_errc must be constexpr");
+		static_assert(hr{ E_OUTOFMEMORY } == std::errc::not_enough_memory && win{ ERROR_SHARING_VIOLATION } != std::errc::file_exists, "errc comparisons must be constexpr");
+		static_assert(detail::win_form(domain::nt, ULONG(STATUS_ACCESS_DENIED)) == detail::win_form(domain::hr, ULONG(E_ACCESSDENIED)), "nt and hr must meet at the win32 code");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "counters.h"
+#include "log_record.h"
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			// every failure seen by a handler comes through here, site is the caller of an out of line throw path
+			inline void count_failure(handler_id h, domain d, ULONG code, const void* site = nullptr) noexcept {
+#if UDLERRORS_COUNTERS
+				counters.count(h, d, code);
+#endif
+#if UDLERRORS_LOG
+				log_failure(h, d, code, site);
+#endif
+				(void)h; (void)d; (void)code; (void)site;
+			}
+		}
+	}
+}
+
+namespace error {
+	inline namespace v0_1_0 {
+		// called by the throw_* handlers in place of throwing when UDLERRORS_EXCEPTIONS is 0
+		// when the hook returns, the handler returns normally - throw_last_error_if returns the invalid value
+		typedef void (*failure_hook)(domain source, ULONG code) noexcept;
+
+		// a failure kept for this thread by record_on_failure
+		struct failure
+		{
+			domain source;
+			ULONG code;
+		};
+
+		namespace detail {
+			inline thread_local failure thread_failure = { domain::none, 0 };
+		}
+
+		// the default - __fastfail, no handlers run and a crash dump is taken
+		inline void fastfail_on_failure(domain, ULONG) noexcept { __fastfail(FAST_FAIL_FATAL_APP_EXIT); }
+
+		// OutputDebugString "udlerrors: <domain> 0x<code>" and abort()
+		inline void abort_on_failure(domain source, ULONG code) noexcept {
+			char text[48] = "udlerrors: ";
+			size_t used = std::char_traits<char>::length(text);
+			for (const char* d = domain_name(source); *d; ++d) { text[used++] = *d; }
+			text[used++] = ' '; text[used++] = '0'; text[used++] = 'x';
+			for (int shift = 28; shift >= 0; shift -= 4) { text[used++] = "0123456789ABCDEF"[(code >> shift) & 0xF]; }
+			text[used++] = '\n'; text[used] = '\0';
+			OutputDebugStringA(text);
+			std::abort();
+		}
+
+		// store the failure for take_failure() and let the caller carry on
+		inline void record_on_failure(domain source, ULONG code) noexcept { detail::thread_failure = failure{ source, code }; }
+
+		// the failure recorded on this thread by record_on_failure, source is domain::none when there is none
+		inline failure take_failure() noexcept { return std::exchange(detail::thread_failure, failure{ domain::none, 0 }); }
+
+		namespace detail {
+			inline std::atomic<failure_hook> failure_hooks{ &fastfail_on_failure };
+
+			inline void report_failure(domain source, ULONG code) noexcept { failure_hooks.load(std::memory_order_acquire)(source, code); }
+		}
+
+		// installs the hook for the whole process, returns the previous hook
+		inline failure_hook set_failure_hook(failure_hook hook) noexcept { return detail::failure_hooks.exchange(hook, std::memory_order_acq_rel); }
+	}
+}
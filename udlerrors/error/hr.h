@@ -0,0 +1,203 @@
+#pragma once
+
+#include "core.h"
+#include "hooks.h"
+#include "message.h"
+
+#if !defined(UDLERRORS_ERROR_INFO)
+#define UDLERRORS_ERROR_INFO 0
+#endif
+
+#if UDLERRORS_ERROR_INFO
+#include <oleauto.h>
+#endif
+
+namespace error {
+	inline namespace v0_1_0 {
+		struct hr
+		{
+			typedef void is_error;
+			static constexpr domain error_domain = domain::hr;
+
+			constexpr inline explicit operator bool() const noexcept { return succeeded(); }
+
+			constexpr bool succeeded() const noexcept {
+				return SUCCEEDED(value);
+			}
+			constexpr bool failed() const noexcept {
+				return FAILED(value);
+			}
+
+			friend constexpr bool operator==(const hr&, const hr&) noexcept = default;
+
+			HRESULT value = S_OK;
+		};
+		// bit 27 (X) is reserved in the HRESULT layout - bit 28 is set by HRESULT_FROM_NT
+		template<>
+		struct packed_check_bit<hr>
+		{
+			static const bool available = true;
+			static const ULONG mask = 0x08000000;
+		};
+#if UDLERRORS_ERROR_INFO
+		namespace detail {
+			// GetErrorInfo only moves the pointer out of the COM state of the thread, nothing is read from it
+			inline IErrorInfo* take_error_info() noexcept {
+				IErrorInfo* info = nullptr;
+				return GetErrorInfo(0, &info) == S_OK ? info : nullptr;
+			}
+
+			// the IErrorInfo of the last failure seen by return_hr or throw_hr on this thread
+			// the description is read the first time it is asked for, a failure that is never described costs one Release
+			// trivially destructible, so no COM reference is released at thread exit, after CoUninitialize
+			// the reference is released by the next failure on the thread or by clear_error_info()
+			class error_info_stash
+			{
+				HRESULT code = S_OK;
+				ULONG stashed = 0;
+				IErrorInfo* info = nullptr;
+				BSTR text = nullptr;
+
+			public:
+				error_info_stash() = default;
+				error_info_stash(const error_info_stash&) = delete;
+				error_info_stash& operator=(const error_info_stash&) = delete;
+
+				void clear() noexcept {
+					if (info) { info->Release(); info = nullptr; }
+					if (text) { SysFreeString(text); text = nullptr; }
+					code = S_OK;
+				}
+				// returns the generation of the stashed failure
+				ULONG stash(HRESULT v, IErrorInfo* taken) noexcept { clear(); code = v; info = taken; return ++stashed; }
+				ULONG generation() const noexcept { return stashed; }
+
+				std::wstring_view describe(HRESULT v) noexcept {
+					if (v != code) {
+						return std::wstring_view();
+					}
+					if (info) {
+						BSTR read = nullptr;
+						if (info->GetDescription(&read) == S_OK) { text = read; }
+						info->Release();
+						info = nullptr;
+					}
+					return text ? std::wstring_view(text, SysStringLen(text)) : std::wstring_view();
+				}
+			};
+			inline thread_local error_info_stash error_info;
+
+			inline __declspec(noinline) ULONG stash_error_info(HRESULT v) noexcept { return error_info.stash(v, take_error_info()); }
+		}
+
+		// the IErrorInfo description of the last failure e seen by return_hr or throw_hr on this thread
+		// empty when the callee set no error info, valid until the next failure on this thread
+		inline std::wstring_view description(const hr& e) noexcept { return detail::error_info.describe(e.value); }
+
+		// releases the error info kept for the last failure on this thread
+		// a thread that saw hr failures calls it before CoUninitialize, the stash is not released at thread exit
+		inline void clear_error_info() noexcept { detail::error_info.clear(); }
+
+		// the description when there is one, otherwise the system message
+		inline size_t message(const hr& e, wchar_t* buffer, size_t size) noexcept {
+			std::wstring_view text = description(e);
+			if (text.empty() || size == 0) {
+				return message<hr>(e, buffer, size);
+			}
+			size_t length = text.copy(buffer, size - 1);
+			buffer[length] = L'\0';
+			return length;
+		}
+#endif
+#if UDLERRORS_EXCEPTIONS
+		struct hr_exception : public error_exception
+		{
+			hr error;
+
+			explicit hr_exception(const hr& e) : error_exception(e), error(e) {}
+#if UDLERRORS_ERROR_INFO
+			// the error info stays in the stash of the throwing thread, the exception only names the thread and the failure
+			// so nothing is released in another apartment when the exception is rethrown on another thread
+			hr_exception(const hr& e, DWORD thread, ULONG generation) noexcept : error_exception(e), error(e), thread(thread), generation(generation) {}
+
+			// the description from the callee when it set one, on the throwing thread until its next failure
+			const char* what() const noexcept override {
+				if (!is_formatted() && thread == GetCurrentThreadId() && generation == detail::error_info.generation()) {
+					std::wstring_view text = detail::error_info.describe(error.value);
+					if (!text.empty()) {
+						return format(text);
+					}
+				}
+				return error_exception::what();
+			}
+
+		private:
+			DWORD thread = 0;
+			ULONG generation = 0;
+#endif
+		};
+
+		namespace detail {
+			[[noreturn]] inline __declspec(noinline) void throw_hr_exception(HRESULT v) {
+				count_failure(handler_id::throw_hr, domain::hr, ULONG(v), _ReturnAddress());
+#if UDLERRORS_ERROR_INFO
+				throw hr_exception{ hr{ v }, GetCurrentThreadId(), stash_error_info(v) };
+#else
+				throw hr_exception{ hr{ v } };
+#endif
+			}
+		}
+#else
+		namespace detail {
+			inline __declspec(noinline) void throw_hr_exception(HRESULT v) noexcept {
+				count_failure(handler_id::throw_hr, domain::hr, ULONG(v), _ReturnAddress());
+#if UDLERRORS_ERROR_INFO
+				stash_error_info(v);
+#endif
+				report_failure(domain::hr, ULONG(v));
+			}
+		}
+#endif
+		struct throw_hr_t
+		{
+			typedef void is_error_handler;
+
+			inline void operator()(HRESULT v) const { if (SUCCEEDED(v)) [[likely]] { return; } detail::throw_hr_exception(v); }
+		};
+		inline throw_hr_t throw_hr{};
+
+		struct return_hr_t
+		{
+			typedef void is_error_handler;
+
+			inline result<void, hr> operator()(HRESULT v) const {
+				if (FAILED(v)) [[unlikely]] {
+					detail::count_failure(handler_id::return_hr, domain::hr, ULONG(v));
+#if UDLERRORS_ERROR_INFO
+					detail::stash_error_info(v);
+#endif
+				}
+				return result<void, hr>{ hr{ v } };
+			}
+		};
+		inline return_hr_t return_hr{};
+	}
+	inline namespace literals {
+		inline namespace hr_literals {
+			constexpr error::hr operator "" _hr(unsigned long long hr) noexcept {
+				return error::hr{ HRESULT(hr) };
+			}
+		}
+	}
+}
+
+UDLERRORS_END_EXPORT
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(ok(0_hr) && ok(1_hr) && !ok(hr{ E_FAIL }) && hr{ E_FAIL }.failed() && hr{ S_FALSE }.succeeded(), "hr classification must be constexpr");
+		static_assert(0_hr != 1_hr && 0_hr == hr{ S_OK }, "comparisons must be constexpr");
+		static_assert(!result<void, hr>{ hr{ E_FAIL } }, "result classification must be constexpr");
+		static_assert(noexcept(ok(0_hr)) && noexcept(0_hr == 0_hr) && noexcept(ok(unique_error<hr>{})), "classification must be noexcept");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
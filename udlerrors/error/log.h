@@ -0,0 +1,50 @@
+#pragma once
+
+#include "log_record.h"
+#include "win.h"
+
+#if UDLERRORS_LOG
+namespace error {
+	inline namespace v0_1_0 {
+		// maps path and starts appending every failure seen by a handler to it
+		// an existing log with the same capacity is continued, anything else is reset
+		// open and close while no handler can be failing on another thread
+		inline win open_error_log(const wchar_t* path, ULONG capacity) noexcept {
+			if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+				return win{ ERROR_INVALID_PARAMETER };
+			}
+			const ULONGLONG size = sizeof(error_log_header) + ULONGLONG(capacity) * sizeof(error_record);
+			auto file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) || make_handle_or_error<invalid_handle_traits, no_check>();
+			if (!file) {
+				return file.error().release();
+			}
+			auto mapping = CreateFileMappingW(file.get(), nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size), nullptr) || make_handle_or_error<null_handle_traits, no_check>();
+			if (!mapping) {
+				return mapping.error().release();
+			}
+			void* view = MapViewOfFile(mapping.get(), FILE_MAP_WRITE, 0, 0, SIZE_T(size));
+			if (!view) {
+				return win{ GetLastError() };
+			}
+			error_log_header* log = static_cast<error_log_header*>(view);
+			if (log->magic != error_log_header::expected_magic || log->version != error_log_header::expected_version || log->record_size != sizeof(error_record) || log->capacity != capacity) {
+				std::memset(view, 0, SIZE_T(size));
+				log->version = error_log_header::expected_version;
+				log->record_size = sizeof(error_record);
+				log->capacity = capacity;
+				log->magic = error_log_header::expected_magic;
+			}
+			if (error_log_header* previous = detail::error_log.exchange(log, std::memory_order_acq_rel)) {
+				UnmapViewOfFile(previous);
+			}
+			return win{};
+		}
+
+		inline void close_error_log() noexcept {
+			if (error_log_header* previous = detail::error_log.exchange(nullptr, std::memory_order_acq_rel)) {
+				UnmapViewOfFile(previous);
+			}
+		}
+	}
+}
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "counters.h"
+
+#if !defined(UDLERRORS_LOG)
+#define UDLERRORS_LOG 0
+#endif
+
+#if UDLERRORS_LOG
+// the base of the module being linked, provided by the linker
+EXTERN_C IMAGE_DOS_HEADER __ImageBase;
+#endif
+
+namespace error {
+	inline namespace v0_1_0 {
+		// the binary error log - a header followed by a ring of fixed size records, in a file mapped by open_error_log()
+		// decoded offline by the errorlog tool
+		struct error_record
+		{
+			ULONGLONG time; // FILETIME, 0 for a slot that was never written
+			ULONG code;
+			ULONG thread;
+			ULONG site; // rva of the failing call in the module that logged it, resolved with its pdb
+			domain source;
+			handler_id handler;
+			USHORT reserved;
+		};
+
+		struct error_log_header
+		{
+			static const ULONG expected_magic = 0x454C4455; // "UDLE"
+			static const ULONG expected_version = 1;
+
+			ULONG magic;
+			ULONG version;
+			ULONG record_size;
+			ULONG capacity; // records that follow the header, power of 2
+			std::atomic<ULONGLONG> next; // records ever written, the oldest is next - capacity
+			BYTE reserved[40];
+
+			error_record* records() noexcept { return reinterpret_cast<error_record*>(this + 1); }
+			const error_record* records() const noexcept { return reinterpret_cast<const error_record*>(this + 1); }
+		};
+
+		namespace detail {
+#if UDLERRORS_LOG
+			inline std::atomic<error_log_header*> error_log{ nullptr };
+
+			// not inlined, so that _ReturnAddress() is in the code that called the handler
+			inline __declspec(noinline) void log_failure(handler_id h, domain d, ULONG code, const void* site) noexcept {
+				error_log_header* log = error_log.load(std::memory_order_acquire);
+				if (!log) {
+					return;
+				}
+				if (!site) {
+					site = _ReturnAddress();
+				}
+				FILETIME now;
+				GetSystemTimePreciseAsFileTime(&now);
+				const error_record record = { (ULONGLONG(now.dwHighDateTime) << 32) | now.dwLowDateTime, code, GetCurrentThreadId(),
+					ULONG(static_cast<const BYTE*>(site) - reinterpret_cast<const BYTE*>(&__ImageBase)), d, h, 0 };
+				const ULONGLONG n = log->next.fetch_add(1, std::memory_order_relaxed);
+				std::memcpy(&log->records()[n & (log->capacity - 1)], &record, sizeof(record));
+			}
+#endif
+		}
+	}
+}
+
+UDLERRORS_END_EXPORT
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(sizeof(error_record) == 24 && std::is_trivially_copyable<error_record>::value, "error_record is a fixed size binary format");
+		static_assert(sizeof(error_log_header) == 64 && std::atomic<ULONGLONG>::is_always_lock_free, "error_log_header is a fixed size binary format");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "core.h"
+
+#include <algorithm>
+#include <new>
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			inline DWORD format_message(domain d, ULONG code, wchar_t* buffer, DWORD size) noexcept {
+				DWORD flags = FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS;
+				const void* source = nullptr;
+				if (d == domain::hr && (code & FACILITY_NT_BIT) != 0) {
+					// HRESULT_FROM_NT
+					d = domain::nt;
+					code &= ~ULONG(FACILITY_NT_BIT);
+				}
+				if (d == domain::nt) {
+					flags = FORMAT_MESSAGE_FROM_HMODULE | FORMAT_MESSAGE_IGNORE_INSERTS;
+					source = GetModuleHandleW(L"ntdll.dll");
+				}
+				DWORD length = FormatMessageW(flags, source, code, 0, buffer, size, nullptr);
+				while (length != 0 && (buffer[length - 1] == L'\r' || buffer[length - 1] == L'\n' || buffer[length - 1] == L' ')) { --length; }
+				if (size != 0) { buffer[length] = L'\0'; }
+				return length;
+			}
+
+			// process-wide, insert-only open addressed table of formatted messages
+			// readers take no lock, each code is formatted once by the thread that claims its slot
+			// a view with a null data() means the code is not cached, an empty view that is not null means it has no text
+			class message_cache
+			{
+				static const size_t capacity = 1024; // power of 2
+				static const DWORD max_length = 512;
+
+				struct slot
+				{
+					std::atomic<ULONGLONG> key;
+					std::atomic<ULONG> length;
+					std::atomic<const wchar_t*> text;
+				};
+				slot slots[capacity];
+
+				static size_t hash(ULONGLONG key) noexcept { return size_t((key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1); }
+
+				static void fill(slot& s, domain d, ULONG code) noexcept {
+					wchar_t buffer[max_length];
+					DWORD length = format_message(d, code, buffer, max_length);
+					wchar_t* text = length == 0 ? nullptr : new (std::nothrow) wchar_t[length + 1];
+					if (text) {
+						std::copy(buffer, buffer + length + 1, text);
+					}
+					else {
+						length = 0;
+					}
+					s.length.store(length, std::memory_order_relaxed);
+					s.text.store(text ? text : L"", std::memory_order_release);
+				}
+
+				static std::wstring_view wait(const slot& s) noexcept {
+					const wchar_t* text;
+					while ((text = s.text.load(std::memory_order_acquire)) == nullptr) { YieldProcessor(); }
+					return std::wstring_view(text, s.length.load(std::memory_order_relaxed));
+				}
+
+			public:
+				// null unless the code has already been formatted, never formats or allocates
+				std::wstring_view find(domain d, ULONG code) const noexcept {
+					const ULONGLONG key = (ULONGLONG(d) << 32) | code;
+					size_t i = hash(key);
+					for (size_t probe = 0; probe != capacity; ++probe, i = (i + 1) & (capacity - 1)) {
+						const slot& s = slots[i];
+						ULONGLONG current = s.key.load(std::memory_order_acquire);
+						if (current == 0) {
+							break;
+						}
+						if (current == key) {
+							const wchar_t* text = s.text.load(std::memory_order_acquire);
+							return text ? std::wstring_view(text, s.length.load(std::memory_order_relaxed)) : std::wstring_view(); // still being formatted
+						}
+					}
+					return std::wstring_view();
+				}
+
+				// empty when the code has no message, null when the cache is full
+				std::wstring_view lookup(domain d, ULONG code) noexcept {
+					const ULONGLONG key = (ULONGLONG(d) << 32) | code;
+					size_t i = hash(key);
+					for (size_t probe = 0; probe != capacity; ++probe, i = (i + 1) & (capacity - 1)) {
+						slot& s = slots[i];
+						ULONGLONG current = s.key.load(std::memory_order_acquire);
+						if (current == 0 && s.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+							fill(s, d, code);
+							current = key;
+						}
+						if (current == key) {
+							return wait(s);
+						}
+					}
+					return std::wstring_view();
+				}
+			};
+
+			inline message_cache messages;
+		}
+
+		// the view refers to the cache and is valid for the life of the process
+		// empty when the code has no message text, data() is null only when the cache is full
+		template<class T, class IsError = typename T::is_error>
+		std::wstring_view message(const T& e) noexcept {
+			return detail::messages.lookup(T::error_domain, ULONG(e.value));
+		}
+
+		// copies the message into buffer, truncated and always terminated
+		// returns the number of characters copied
+		template<class T, class IsError = typename T::is_error>
+		size_t message(const T& e, wchar_t* buffer, size_t size) noexcept {
+			if (size == 0) {
+				return 0;
+			}
+			auto text = message(e);
+			if (text.data() == nullptr) {
+				// the cache is full, format straight into the caller's buffer
+				return detail::format_message(T::error_domain, ULONG(e.value), buffer, DWORD(size < 0x10000 ? size : 0x10000));
+			}
+			size_t length = text.copy(buffer, size - 1);
+			buffer[length] = L'\0';
+			return length;
+		}
+	}
+}
+
+#if !defined(UDLERRORS_WHAT_MESSAGE)
+#define UDLERRORS_WHAT_MESSAGE 1
+#endif
+
+#if UDLERRORS_EXCEPTIONS
+namespace error {
+	inline namespace v0_1_0 {
+		inline const char* error_exception::what() const noexcept {
+			if (formatted) {
+				return text;
+			}
+#if UDLERRORS_WHAT_MESSAGE
+			// the cached text once the code has been formatted, even when it has none, otherwise formatted on the stack and not cached
+			wchar_t buffer[max_text];
+			std::wstring_view wide = detail::messages.find(source, code);
+			if (wide.data() == nullptr) {
+				wide = std::wstring_view(buffer, detail::format_message(source, code, buffer, DWORD(max_text)));
+			}
+			return format(wide);
+#else
+			return format(std::wstring_view());
+#endif
+		}
+
+		inline const char* error_exception::format(std::wstring_view wide) const noexcept {
+			static const char digits[] = "0123456789ABCDEF";
+			const char* tag = domain_name(source);
+			char* out = text;
+			char* const end = text + max_text - 1;
+			while (*tag) { *out++ = *tag++; }
+			*out++ = ' '; *out++ = '0'; *out++ = 'x';
+			for (int shift = 28; shift >= 0; shift -= 4) { *out++ = digits[(code >> shift) & 0xF]; }
+			if (!wide.empty()) {
+				*out++ = ':'; *out++ = ' ';
+				// utf-8 needs at most 3 bytes per utf-16 unit, so the shortened text always fits
+				int room = int(end - out);
+				int length = WideCharToMultiByte(CP_UTF8, 0, wide.data(), int(wide.size()), out, room, nullptr, nullptr);
+				if (length == 0) {
+					size_t units = std::min(wide.size(), size_t(room / 3));
+					if (units != 0 && wide[units - 1] >= 0xD800 && wide[units - 1] < 0xDC00) { --units; }
+					length = WideCharToMultiByte(CP_UTF8, 0, wide.data(), int(units), out, room, nullptr, nullptr);
+				}
+				out += length;
+				if (length == 0) { out -= 2; }
+			}
+			*out = '\0';
+			formatted = true;
+			return text;
+		}
+	}
+}
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "core.h"
+#include "hooks.h"
+#include "message.h"
+
+#include <winternl.h>
+#pragma warning(push)
+#pragma warning(disable : 4005) // ntstatus.h redefines the STATUS_ codes that winnt.h defines unless WIN32_NO_STATUS was set
+#include <ntstatus.h>
+#pragma warning(pop)
+
+namespace error {
+	inline namespace v0_1_0 {
+		struct nt
+		{
+			typedef void is_error;
+			static constexpr domain error_domain = domain::nt;
+
+			constexpr inline explicit operator bool() const noexcept { return !error(); }
+
+			constexpr bool success() const noexcept {
+				return NT_SUCCESS(value);
+			}
+			constexpr bool information() const noexcept {
+				return NT_INFORMATION(value);
+			}
+			constexpr bool warning() const noexcept {
+				return NT_WARNING(value);
+			}
+			constexpr bool error() const noexcept {
+				return NT_ERROR(value);
+			}
+
+			friend constexpr bool operator==(const nt&, const nt&) noexcept = default;
+
+			NTSTATUS value = STATUS_SUCCESS;
+		};
+		// bit 28 (N) is reserved in the NTSTATUS layout
+		template<>
+		struct packed_check_bit<nt>
+		{
+			static const bool available = true;
+			static const ULONG mask = 0x10000000;
+		};
+#if UDLERRORS_EXCEPTIONS
+		struct nt_exception : public error_exception
+		{
+			nt error;
+
+			explicit nt_exception(const nt& e) : error_exception(e), error(e) {}
+		};
+
+		namespace detail {
+			[[noreturn]] inline __declspec(noinline) void throw_nt_exception(NTSTATUS v) {
+				count_failure(handler_id::throw_nt, domain::nt, ULONG(v), _ReturnAddress());
+				throw nt_exception{ nt{ v } };
+			}
+		}
+#else
+		namespace detail {
+			inline __declspec(noinline) void throw_nt_exception(NTSTATUS v) noexcept {
+				count_failure(handler_id::throw_nt, domain::nt, ULONG(v), _ReturnAddress());
+				report_failure(domain::nt, ULONG(v));
+			}
+		}
+#endif
+		struct throw_nt_t
+		{
+			typedef void is_error_handler;
+
+			inline void operator()(NTSTATUS v) const { if (!NT_ERROR(v)) [[likely]] { return; } detail::throw_nt_exception(v); }
+			// an nt, e.g. from error::ntdll
+			inline void operator()(const nt& e) const { (*this)(e.value); }
+		};
+		inline throw_nt_t throw_nt{};
+
+		struct return_nt_t
+		{
+			typedef void is_error_handler;
+
+			inline result<void, nt> operator()(NTSTATUS v) const {
+				if (NT_ERROR(v)) [[unlikely]] { detail::count_failure(handler_id::return_nt, domain::nt, ULONG(v)); }
+				return result<void, nt>{ nt{ v } };
+			}
+			inline result<void, nt> operator()(const nt& e) const { return (*this)(e.value); }
+		};
+		inline return_nt_t return_nt{};
+
+		template<>
+		struct pending_status<nt>
+		{
+			static const bool available = true;
+			static const ULONG value = ULONG(STATUS_PENDING);
+		};
+
+		// for NtReadFile, NtDeviceIoControlFile, ... that return STATUS_PENDING when the request is queued
+		struct pending_ok_nt_t
+		{
+			typedef void is_error_handler;
+
+			inline pending_result<void, nt> operator()(NTSTATUS v) const {
+				if (NT_ERROR(v)) [[unlikely]] { detail::count_failure(handler_id::pending_ok_nt, domain::nt, ULONG(v)); }
+				return pending_result<void, nt>{ nt{ v } };
+			}
+			inline pending_result<void, nt> operator()(const nt& e) const { return (*this)(e.value); }
+		};
+		inline pending_ok_nt_t pending_ok_nt{};
+	}
+	inline namespace literals {
+		inline namespace nt_literals {
+			constexpr error::nt operator "" _nt(unsigned long long nt) noexcept {
+				return error::nt{ NTSTATUS(nt) };
+			}
+		}
+	}
+}
+
+UDLERRORS_END_EXPORT
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(ok(0_nt) && ok(nt{ STATUS_PENDING }) && ok(nt{ STATUS_BUFFER_OVERFLOW }) && !ok(nt{ STATUS_ACCESS_DENIED }) && 0_nt == nt{}, "nt classification must be constexpr");
+		static_assert(nt{ STATUS_PENDING }.success() && nt{ STATUS_BUFFER_OVERFLOW }.warning() && nt{ STATUS_ACCESS_DENIED }.error() && !nt{}.information(), "nt severity must be constexpr");
+		static_assert(pending_result<void, nt>{ nt{ STATUS_PENDING } }.pending() && pending_result<void, nt>{ 0_nt }.completed() && !pending_result<void, nt>{ nt{ STATUS_ACCESS_DENIED } }, "nt pending classification must be constexpr");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "nt.h"
+
+// ntdll entry points that error::ntdll wraps, X(name, parameters, arguments)
+// resolved together by GetProcAddress on the first call to any of them
+#define UDLERRORS_NTDLL_FUNCTIONS(X) \
+	X(NtClose, (HANDLE handle), (handle)) \
+	X(NtWaitForSingleObject, (HANDLE handle, BOOLEAN alertable, PLARGE_INTEGER timeout), (handle, alertable, timeout)) \
+	X(NtQueryInformationProcess, (HANDLE process, PROCESSINFOCLASS info, PVOID buffer, ULONG length, PULONG returned), (process, info, buffer, length, returned)) \
+	X(NtQueryInformationThread, (HANDLE thread, THREADINFOCLASS info, PVOID buffer, ULONG length, PULONG returned), (thread, info, buffer, length, returned)) \
+	X(NtQueryObject, (HANDLE handle, OBJECT_INFORMATION_CLASS info, PVOID buffer, ULONG length, PULONG returned), (handle, info, buffer, length, returned)) \
+	X(NtQuerySystemInformation, (SYSTEM_INFORMATION_CLASS info, PVOID buffer, ULONG length, PULONG returned), (info, buffer, length, returned)) \
+	X(NtQueryInformationFile, (HANDLE file, PIO_STATUS_BLOCK io, PVOID buffer, ULONG length, FILE_INFORMATION_CLASS info), (file, io, buffer, length, info)) \
+	X(NtSetInformationFile, (HANDLE file, PIO_STATUS_BLOCK io, PVOID buffer, ULONG length, FILE_INFORMATION_CLASS info), (file, io, buffer, length, info)) \
+	X(NtFlushBuffersFile, (HANDLE file, PIO_STATUS_BLOCK io), (file, io)) \
+	X(NtDeviceIoControlFile, (HANDLE file, HANDLE event, PIO_APC_ROUTINE apc, PVOID context, PIO_STATUS_BLOCK io, ULONG code, PVOID input, ULONG input_length, PVOID output, ULONG output_length), \
+		(file, event, apc, context, io, code, input, input_length, output, output_length))
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			struct ntdll_functions
+			{
+#define UDLERRORS_POINTER(NAME, PARAMETERS, ARGUMENTS) NTSTATUS (NTAPI* NAME) PARAMETERS;
+				UDLERRORS_NTDLL_FUNCTIONS(UDLERRORS_POINTER)
+#undef UDLERRORS_POINTER
+			};
+
+			// ntdll is mapped into every process before any code runs, so the module is never loaded or freed here
+			inline ntdll_functions resolve_ntdll() noexcept {
+				ntdll_functions functions = {};
+				if (HMODULE ntdll = GetModuleHandleW(L"ntdll.dll")) {
+#define UDLERRORS_RESOLVE(NAME, PARAMETERS, ARGUMENTS) functions.NAME = reinterpret_cast<decltype(functions.NAME)>(GetProcAddress(ntdll, #NAME));
+					UDLERRORS_NTDLL_FUNCTIONS(UDLERRORS_RESOLVE)
+#undef UDLERRORS_RESOLVE
+				}
+				return functions;
+			}
+
+			// the first call resolves the table, every later call is the thread safe static guard and a load
+			inline const ntdll_functions& ntdll_table() noexcept {
+				static const ntdll_functions table = resolve_ntdll();
+				return table;
+			}
+		}
+
+		// error::ntdll::NtClose(h) || throw_nt - the ntdll calls with the same names and parameters, returning nt
+		// an entry point that is missing from this version of ntdll returns STATUS_ENTRYPOINT_NOT_FOUND
+		// call them qualified, argument dependent lookup through the winternl.h enums also finds the SDK declarations
+		namespace ntdll {
+#define UDLERRORS_WRAPPER(NAME, PARAMETERS, ARGUMENTS) \
+			inline nt NAME PARAMETERS noexcept { \
+				const auto function = detail::ntdll_table().NAME; \
+				return nt{ function ? function ARGUMENTS : NTSTATUS(STATUS_ENTRYPOINT_NOT_FOUND) }; \
+			}
+			UDLERRORS_NTDLL_FUNCTIONS(UDLERRORS_WRAPPER)
+#undef UDLERRORS_WRAPPER
+
+			// T is the fixed size structure of the information class, e.g. PROCESS_BASIC_INFORMATION for ProcessBasicInformation
+			// failures are counted as return_nt failures
+			template<class T>
+			result<T, nt> query_information_process(HANDLE process, PROCESSINFOCLASS info) noexcept {
+				T value = {};
+				const nt status = (ntdll::NtQueryInformationProcess(process, info, &value, ULONG(sizeof(T)), nullptr) || return_nt).error();
+				return result<T, nt>{ status, value };
+			}
+			template<class T>
+			result<T, nt> query_information_thread(HANDLE thread, THREADINFOCLASS info) noexcept {
+				T value = {};
+				const nt status = (ntdll::NtQueryInformationThread(thread, info, &value, ULONG(sizeof(T)), nullptr) || return_nt).error();
+				return result<T, nt>{ status, value };
+			}
+			template<class T>
+			result<T, nt> query_information_file(HANDLE file, FILE_INFORMATION_CLASS info) noexcept {
+				T value = {};
+				IO_STATUS_BLOCK io = {};
+				const nt status = (ntdll::NtQueryInformationFile(file, &io, &value, ULONG(sizeof(T)), info) || return_nt).error();
+				return result<T, nt>{ status, value };
+			}
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "core.h"
+#include "hooks.h"
+#include "win.h"
+
+namespace error {
+	inline namespace v0_1_0 {
+		// how retry_if waits before each retry - spins, then yields, then sleeps with exponential backoff and jitter
+		// the number of retries is capped at spins + yields + sleeps
+		struct retry_policy
+		{
+			unsigned spins = 8; // retry n spins for 2^n pauses
+			unsigned yields = 4; // SwitchToThread
+			unsigned sleeps = 6; // sleep n is up to first_sleep * 2^n milliseconds, never more than max_sleep
+			DWORD first_sleep = 1;
+			DWORD max_sleep = 64;
+
+			constexpr unsigned attempts() const noexcept { return spins + yields + sleeps; }
+
+			// the wait before retry n, the first retry is 0
+			void wait(unsigned n) const noexcept;
+		};
+
+		// what the last attempt returned and how many retries it took to get it
+		template<class R>
+		struct [[nodiscard]] retry_result
+		{
+			R result;
+			unsigned retries;
+
+			constexpr bool ok() const noexcept { return error::ok(result); }
+			constexpr explicit operator bool() const noexcept { return ok(); }
+		};
+		template<class R> constexpr bool ok(const retry_result<R>& r) noexcept { return r.ok(); }
+
+		namespace detail {
+			// xorshift, seeded per thread so that threads that failed together do not wake together
+			inline DWORD jitter(DWORD range) noexcept {
+				thread_local ULONGLONG state = (ULONGLONG(GetCurrentThreadId()) * 0x9E3779B97F4A7C15ull) ^ GetTickCount64() ^ 1;
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+				return range == 0 ? 0 : DWORD(state % range);
+			}
+
+			// the error in what an attempt returned
+			template<class E, class IsError = typename E::is_error> constexpr E error_of(const E& e) noexcept { return e; }
+			template<class T, class E> constexpr E error_of(const result<T, E>& r) noexcept { return r.error(); }
+			template<class T, class E> constexpr E error_of(const pending_result<T, E>& r) noexcept { return r.error(); }
+			template<class E, class P> E error_of(const unique_error<E, P>& u) noexcept { return u.get(); }
+			template<class Traits, class P> win error_of(const unique_handle<Traits, P>& h) noexcept { return h.error().get(); }
+
+			// an attempt that is retried was seen by retry_if, so its error is safe to replace
+			template<class R> void discard(R&) noexcept {}
+			template<class E, class P> void discard(unique_error<E, P>& u) noexcept { u.release(); }
+			template<class Traits, class P> void discard(unique_handle<Traits, P>& h) noexcept { h.error().release(); }
+
+			template<class E, size_t N>
+			struct any_of_codes
+			{
+				E codes[N];
+
+				constexpr bool operator()(const E& e) const noexcept {
+					for (size_t i = 0; i != N; ++i) {
+						if (codes[i] == e) {
+							return true;
+						}
+					}
+					return false;
+				}
+			};
+		}
+
+		inline void retry_policy::wait(unsigned n) const noexcept {
+			if (n < spins) {
+				for (unsigned i = 0, pauses = 1u << (n < 10 ? n : 10); i != pauses; ++i) {
+					YieldProcessor();
+				}
+			}
+			else if (n < spins + yields) {
+				SwitchToThread();
+			}
+			else {
+				const unsigned k = n - spins - yields;
+				const DWORD longest = k < 16 && (first_sleep << k) < max_sleep ? first_sleep << k : max_sleep;
+				// equal jitter - at least half the backoff, so the waits still grow
+				Sleep(longest / 2 + detail::jitter(longest - longest / 2 + 1));
+			}
+		}
+
+		// retry_if(codes, policy) || op calls op() until what it returns is not transient or the retries run out
+		// transient is a list of codes or a predicate on the error, e.g. a dispatch_table<E, bool>
+		// each retried failure is counted as a retry_if failure
+		template<class Transient>
+		struct retry_if_t
+		{
+			Transient transient;
+			retry_policy policy;
+
+			template<class F>
+			friend auto operator||(const retry_if_t& r, F&& op) -> retry_result<decltype(op())> {
+				auto last = op();
+				typedef decltype(detail::error_of(last)) error_type;
+				unsigned retries = 0;
+				for (; retries != r.policy.attempts(); ++retries) {
+					const error_type e = detail::error_of(last);
+					if (!r.transient(e)) {
+						break;
+					}
+					detail::count_failure(handler_id::retry_if, error_type::error_domain, ULONG(e.value));
+					r.policy.wait(retries);
+					detail::discard(last);
+					last = op();
+				}
+				return retry_result<decltype(op())>{ std::move(last), retries };
+			}
+		};
+
+		// retry_if({ win{ ERROR_SHARING_VIOLATION }, win{ ERROR_LOCK_VIOLATION } }), the codes are kept by value
+		template<class E, size_t N, class IsError = typename E::is_error>
+		retry_if_t<detail::any_of_codes<E, N>> retry_if(const E (&codes)[N], const retry_policy& policy = retry_policy()) noexcept {
+			detail::any_of_codes<E, N> any = {};
+			for (size_t i = 0; i != N; ++i) { any.codes[i] = codes[i]; }
+			return retry_if_t<detail::any_of_codes<E, N>>{ any, policy };
+		}
+
+		template<class Transient>
+		retry_if_t<Transient> retry_if(Transient transient, const retry_policy& policy = retry_policy()) noexcept {
+			return retry_if_t<Transient>{ transient, policy };
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "core.h"
+
+#include <atomic>
+
+namespace error {
+	inline namespace v0_1_0 {
+		namespace detail {
+			template<class T, class CheckPolicy, bool Checked = CheckPolicy::checked>
+			class shared_error_state;
+
+			// the error is written once, before it is shared, only the flag is written by consumers
+			// a consumer loads the flag before it stores, so consumers that check repeatedly do not contend for the line
+			// relaxed is enough - the thread that destroys the error is already ordered after the consumers by whatever joins them
+			template<class T, class CheckPolicy>
+			class shared_error_state<T, CheckPolicy, true> : private CheckPolicy::call_site
+			{
+				typedef typename CheckPolicy::call_site call_site;
+
+				const T error;
+				mutable std::atomic<bool> issafe;
+
+			protected:
+				void mark() const noexcept { if (!issafe.load(std::memory_order_relaxed)) { issafe.store(true, std::memory_order_relaxed); } }
+
+				~shared_error_state() { if (!issafe.load(std::memory_order_relaxed)) { CheckPolicy::unchecked(error, *this); } }
+
+				shared_error_state() noexcept : error(), issafe(true) {}
+				shared_error_state(const T& e, bool safe, const call_site& s) noexcept : call_site(s), error(e), issafe(safe) {}
+
+			public:
+				const T& get() const noexcept { return error; }
+
+				bool is_safe() const noexcept { return issafe.load(std::memory_order_relaxed); }
+			};
+
+			template<class T, class CheckPolicy>
+			class shared_error_state<T, CheckPolicy, false>
+			{
+				typedef typename CheckPolicy::call_site call_site;
+
+				const T error;
+
+			protected:
+				void mark() const noexcept {}
+
+				shared_error_state() noexcept : error() {}
+				shared_error_state(const T& e, bool, const call_site&) noexcept : error(e) {}
+
+			public:
+				const T& get() const noexcept { return error; }
+
+				bool is_safe() const noexcept { return true; }
+			};
+		}
+
+		// shared_error<T> - one error read by many threads, e.g. the status of a completion that is broadcast
+		// ok() from any one consumer meets the obligation to check, and is safe to call concurrently with the others
+		// shared by reference - the error cannot change and the obligation cannot move, so it is neither copied nor moved
+		// Padded puts each error on its own cache line, for an array of errors written by different threads
+		template<class T, class CheckPolicy = default_check, bool Padded = false, class IsError = typename T::is_error>
+		class alignas(Padded ? 64 : alignof(detail::shared_error_state<T, CheckPolicy>)) shared_error : public detail::shared_error_state<T, CheckPolicy>
+		{
+			typedef detail::shared_error_state<T, CheckPolicy> state;
+			typedef typename CheckPolicy::call_site call_site;
+
+		public:
+			shared_error() noexcept {}
+			template<class V>
+			shared_error(V v, const std::source_location& where = std::source_location::current()) noexcept(std::is_nothrow_constructible<T, V>::value) : state(T{ v }, false, call_site{ where }) {}
+			// takes over the obligation to check u
+			template<class P>
+			explicit shared_error(unique_error<T, P>&& u, const std::source_location& where = std::source_location::current()) noexcept : state(u.get(), u.is_safe(), call_site{ where }) { u.release(); }
+
+			shared_error(const shared_error&) = delete;
+			shared_error& operator=(const shared_error&) = delete;
+
+			bool ok() const noexcept { state::mark(); return error::ok(state::get()); }
+			explicit operator bool() const noexcept { return ok(); }
+
+			friend bool operator==(const std::same_as<shared_error> auto& lhs, const std::same_as<T> auto& rhs) noexcept { return lhs.get().value == rhs.value; }
+		};
+
+		template<class T, class CheckPolicy = default_check>
+		using padded_shared_error = shared_error<T, CheckPolicy, true>;
+
+		template<class T, class CheckPolicy, bool Padded, class IsError = typename T::is_error> bool ok(const shared_error<T, CheckPolicy, Padded>& t) noexcept { return t.ok(); }
+	}
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "conversions.h"
+
+#include <coroutine>
+#include <optional>
+
+namespace error {
+	inline namespace v0_1_0 {
+		template<class T, class E = hr>
+		class task;
+
+		namespace detail {
+			// the conversions co_await applies to an error from another domain
+			template<class To, class From>
+			struct error_conversion;
+			template<class E>
+			struct error_conversion<E, E> { static constexpr E convert(const E& e) noexcept { return e; } };
+			template<>
+			struct error_conversion<hr, win> { static constexpr hr convert(const win& e) noexcept { return to_hr(e); } };
+			template<>
+			struct error_conversion<hr, nt> { static constexpr hr convert(const nt& e) noexcept { return to_hr(e); } };
+			template<>
+			struct error_conversion<win, nt> { static constexpr win convert(const nt& e) noexcept { return to_win(e); } };
+
+			template<class To, class From>
+			concept converts_to_error = requires(const From& f) { error_conversion<To, From>::convert(f); };
+
+			template<class X>
+			struct is_result : std::false_type {};
+			template<class T, class E>
+			struct is_result<result<T, E>> : std::true_type {};
+
+			template<class X>
+			struct is_task : std::false_type {};
+			template<class T, class E>
+			struct is_task<task<T, E>> : std::true_type {};
+
+			template<class E>
+			struct task_promise_base
+			{
+				// the outcome of a task that nothing awaits, it must be checked by the owner of the task
+				unique_error<E> outcome;
+#if UDLERRORS_EXCEPTIONS
+				std::exception_ptr exception;
+#endif
+				std::coroutine_handle<> continuation;
+				// set when another task awaits this one, failures go straight to it
+				std::coroutine_handle<>(*fail_parent)(void*, const E&) noexcept = nullptr;
+				void* parent = nullptr;
+				bool completed = false;
+				bool failed = false;
+
+				std::coroutine_handle<> next() const noexcept { return continuation ? continuation : std::noop_coroutine(); }
+
+				// completes the task with e, the coroutine stays suspended until the task is destroyed
+				std::coroutine_handle<> fail(const E& e) noexcept {
+					completed = true;
+					failed = true;
+					if (fail_parent) {
+						return fail_parent(parent, e);
+					}
+					outcome.reset(e);
+					return next();
+				}
+
+				struct final_awaiter
+				{
+					bool await_ready() const noexcept { return false; }
+					template<class Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+						auto& p = h.promise();
+						p.completed = true;
+						if (!p.fail_parent && !p.threw()) {
+							p.outcome.reset(E{});
+						}
+						return p.next();
+					}
+					void await_resume() const noexcept {}
+				};
+
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+				final_awaiter final_suspend() const noexcept { return {}; }
+#if UDLERRORS_EXCEPTIONS
+				void unhandled_exception() noexcept { exception = std::current_exception(); }
+				bool threw() const noexcept { return !!exception; }
+				void rethrow() const { if (exception) { std::rethrow_exception(exception); } }
+#else
+				void unhandled_exception() noexcept { std::abort(); }
+				bool threw() const noexcept { return false; }
+				void rethrow() const noexcept {}
+#endif
+
+				struct error_awaiter
+				{
+					E status;
+
+					bool await_ready() const noexcept { return error::ok(status); }
+					template<class Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept { return h.promise().fail(status); }
+					void await_resume() const noexcept {}
+				};
+
+				template<class T>
+				struct result_awaiter
+				{
+					E status;
+					T value;
+
+					bool await_ready() const noexcept { return error::ok(status); }
+					template<class Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept { return h.promise().fail(status); }
+					T await_resume() noexcept { return std::move(value); }
+				};
+
+				template<class T, class E2>
+				struct task_awaiter
+				{
+					task<T, E2>& child;
+
+					static std::coroutine_handle<> fail_promise(void* p, const E2& e) noexcept {
+						return static_cast<task_promise_base*>(p)->fail(error_conversion<E, E2>::convert(e));
+					}
+
+					bool await_ready() const noexcept { return false; }
+					template<class Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+						auto& p = child.h.promise();
+						p.continuation = h;
+						p.parent = static_cast<task_promise_base*>(&h.promise());
+						p.fail_parent = &fail_promise;
+						return child.h;
+					}
+					T await_resume() {
+						auto& p = child.h.promise();
+						p.rethrow();
+						if constexpr (!std::is_void<T>::value) {
+							return std::move(*p.value);
+						}
+					}
+				};
+
+				// co_await of an error, a result or a task continues on success and completes this task on failure
+				template<class X>
+					requires converts_to_error<E, X>
+				error_awaiter await_transform(const X& e) const noexcept { return error_awaiter{ error_conversion<E, X>::convert(e) }; }
+
+				template<class T, class X>
+					requires converts_to_error<E, X>
+				result_awaiter<T> await_transform(const result<T, X>& r) const noexcept { return result_awaiter<T>{ error_conversion<E, X>::convert(r.error()), r.value() }; }
+
+				template<class X>
+					requires converts_to_error<E, X>
+				error_awaiter await_transform(const result<void, X>& r) const noexcept { return error_awaiter{ error_conversion<E, X>::convert(r.error()) }; }
+
+				template<class T, class X>
+					requires converts_to_error<E, X>
+				task_awaiter<T, X> await_transform(task<T, X>&& t) const noexcept { return task_awaiter<T, X>{ t }; }
+
+				// any other awaitable is unchanged
+				template<class A>
+					requires (!converts_to_error<E, std::remove_cvref_t<A>> && !is_result<std::remove_cvref_t<A>>::value && !is_task<std::remove_cvref_t<A>>::value)
+				A&& await_transform(A&& a) const noexcept { return std::forward<A>(a); }
+			};
+
+			template<class T, class E>
+			struct task_promise : public task_promise_base<E>
+			{
+				std::optional<T> value;
+
+				task<T, E> get_return_object() noexcept;
+
+				template<class U>
+				void return_value(U&& u) { value.emplace(std::forward<U>(u)); }
+			};
+
+			template<class E>
+			struct task_promise<void, E> : public task_promise_base<E>
+			{
+				task<void, E> get_return_object() noexcept;
+
+				void return_void() noexcept {}
+			};
+		}
+
+		// lazily started coroutine that completes with a T or with an error of type E
+		// inside the coroutine, co_await on an error, a result or a task yields the value and
+		// completes the coroutine with the error on failure - no exception is thrown
+		// the outcome of a task that is not awaited by another task is a unique_error<E>
+		template<class T, class E>
+		class [[nodiscard]] task
+		{
+		public:
+			typedef detail::task_promise<T, E> promise_type;
+
+		private:
+			template<class E2>
+			friend struct detail::task_promise_base;
+			friend promise_type;
+
+			std::coroutine_handle<promise_type> h;
+
+			explicit task(std::coroutine_handle<promise_type> c) noexcept : h(c) {}
+
+		public:
+			task(task&& o) noexcept : h(std::exchange(o.h, nullptr)) {}
+			task& operator=(task&& o) noexcept { if (this != &o) { if (h) { h.destroy(); } h = std::exchange(o.h, nullptr); } return *this; }
+			~task() { if (h) { h.destroy(); } }
+
+			// runs a task that nothing awaits until it completes or first suspends
+			void start() { assert(h && !h.promise().completed); h.resume(); }
+
+			// false for a task that has not completed and for a moved-from task
+			bool done() const noexcept { return h && h.promise().completed; }
+
+			// a task that is not done has no outcome and is not ok
+			bool ok() const { return done() && (rethrow(), h.promise().outcome.ok()); }
+			explicit operator bool() const { return ok(); }
+
+			// error() and value() fail fast on a task that is not done, there is nothing to refer to
+			unique_error<E>& error() { rethrow(); return completed().outcome; }
+
+			// value() of a task that failed reports its error to the failure hook, the default hook fails fast
+			// a hook that returns, like record_on_failure, gets a value initialized U
+			template<class U = T>
+				requires (!std::is_void<U>::value)
+			U& value() {
+				rethrow();
+				promise_type& p = completed();
+				if (!p.outcome.ok()) [[unlikely]] {
+					detail::report_failure(E::error_domain, ULONG(p.outcome.get().value));
+					if constexpr (std::is_default_constructible<U>::value) {
+						p.value.emplace();
+					}
+					else {
+						__fastfail(FAST_FAIL_FATAL_APP_EXIT);
+					}
+				}
+				return *p.value;
+			}
+
+		private:
+			promise_type& completed() const noexcept {
+				assert(done());
+				if (!done()) {
+					__fastfail(FAST_FAIL_FATAL_APP_EXIT);
+				}
+				return h.promise();
+			}
+			void rethrow() const { completed().rethrow(); }
+		};
+
+		namespace detail {
+			template<class T, class E>
+			task<T, E> task_promise<T, E>::get_return_object() noexcept { return task<T, E>{ std::coroutine_handle<task_promise>::from_promise(*this) }; }
+			template<class E>
+			task<void, E> task_promise<void, E>::get_return_object() noexcept { return task<void, E>{ std::coroutine_handle<task_promise>::from_promise(*this) }; }
+		}
+	}
+}
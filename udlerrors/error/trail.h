@@ -0,0 +1,116 @@
+#pragma once
+
+#include "core.h"
+
+#if !defined(UDLERRORS_TRAIL)
+#define UDLERRORS_TRAIL 0
+#endif
+
+namespace error {
+	inline namespace v0_1_0 {
+		// one step of the path taken by a failure, pushed by trace()
+		struct error_frame
+		{
+			domain source;
+			ULONG code;
+			const char* file;
+			const char* function;
+			ULONG line;
+		};
+
+#if UDLERRORS_TRAIL
+		namespace detail {
+			// the most recent frames pushed on this thread, older frames are overwritten
+			class error_trail
+			{
+				static const size_t capacity = 64; // power of 2
+
+				error_frame frames[capacity];
+				size_t next = 0;
+
+			public:
+				void push(domain d, ULONG code, const std::source_location& where) noexcept {
+					frames[next++ & (capacity - 1)] = error_frame{ d, code, where.file_name(), where.function_name(), ULONG(where.line()) };
+				}
+
+				// oldest first
+				size_t copy(error_frame* out, size_t size) const noexcept {
+					const size_t first = next > capacity ? next - capacity : 0;
+					size_t used = 0;
+					for (size_t n = first; n != next && used != size; ++n) { out[used++] = frames[n & (capacity - 1)]; }
+					return used;
+				}
+
+				void clear() noexcept { next = 0; }
+			};
+
+			inline thread_local error_trail trail;
+
+			inline void push_frame(domain d, ULONG code, const std::source_location& where) noexcept { trail.push(d, code, where); }
+
+			inline char* append(char* out, char* end, const char* s) noexcept { while (*s && out != end) { *out++ = *s++; } return out; }
+		}
+
+		// copies the frames pushed on this thread since the last clear, oldest first
+		inline size_t error_trail(error_frame* out, size_t size) noexcept { return detail::trail.copy(out, size); }
+
+		// called once the error at the end of the trail is handled
+		inline void clear_error_trail() noexcept { detail::trail.clear(); }
+
+		// OutputDebugString one "file(line): function: <domain> 0x<code>" line per frame, then clear
+		inline void dump_error_trail() noexcept {
+			error_frame frames[64];
+			const size_t used = error_trail(frames, 64);
+			for (size_t i = 0; i != used; ++i) {
+				char text[512];
+				char* const end = text + sizeof(text) - 24;
+				char* out = detail::append(text, end, frames[i].file);
+				char digits[10];
+				int count = 0;
+				for (ULONG line = frames[i].line; count == 0 || line != 0; line /= 10) { digits[count++] = char('0' + line % 10); }
+				out = detail::append(out, end, "(");
+				while (count != 0 && out != end) { *out++ = digits[--count]; }
+				out = detail::append(out, end, "): ");
+				out = detail::append(out, end, frames[i].function);
+				out = detail::append(out, end, ": ");
+				out = detail::append(out, end, domain_name(frames[i].source));
+				// room for the code was kept back from end
+				*out++ = ' '; *out++ = '0'; *out++ = 'x';
+				for (int shift = 28; shift >= 0; shift -= 4) { *out++ = "0123456789ABCDEF"[(frames[i].code >> shift) & 0xF]; }
+				*out++ = '\n'; *out = '\0';
+				OutputDebugStringA(text);
+			}
+			clear_error_trail();
+		}
+#else
+		namespace detail {
+			inline void push_frame(domain, ULONG, const std::source_location&) noexcept {}
+		}
+
+		inline size_t error_trail(error_frame*, size_t) noexcept { return 0; }
+		inline void clear_error_trail() noexcept {}
+		inline void dump_error_trail() noexcept {}
+#endif
+
+		// trace(e) - push a frame for this call site when e is a failure and pass e on
+		// return trace(hres); at each layer leaves the path the failure took in error_trail()
+		template<class T, class IsError = typename T::is_error>
+		T trace(T e, const std::source_location& where = std::source_location::current()) noexcept {
+			if (!error::ok(e)) [[unlikely]] { detail::push_frame(T::error_domain, ULONG(e.value), where); }
+			return e;
+		}
+		template<class T, class E, class IsError = typename E::is_error>
+		result<T, E> trace(const result<T, E>& r, const std::source_location& where = std::source_location::current()) noexcept {
+			if (!r.ok()) [[unlikely]] { detail::push_frame(E::error_domain, ULONG(r.error().value), where); }
+			return r;
+		}
+		// does not count as checking the error
+		template<class T, class P>
+		unique_error<T, P>& trace(unique_error<T, P>& e, const std::source_location& where = std::source_location::current()) noexcept {
+			if (!error::ok(e.get())) [[unlikely]] { detail::push_frame(T::error_domain, ULONG(e.get().value), where); }
+			return e;
+		}
+		template<class T, class P>
+		unique_error<T, P>&& trace(unique_error<T, P>&& e, const std::source_location& where = std::source_location::current()) noexcept { return std::move(trace(e, where)); }
+	}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "core.h"
+#include "hooks.h"
+#include "message.h"
+
+namespace error {
+	inline namespace v0_1_0 {
+		struct win
+		{
+			typedef void is_error;
+			static constexpr domain error_domain = domain::win;
+
+			constexpr inline explicit operator bool () const noexcept { return value == 0; }
+
+			friend constexpr bool operator==(const win&, const win&) noexcept = default;
+
+			DWORD value = NOERROR;
+		};
+		// bit 28 is reserved in the win32 error code layout
+		template<>
+		struct packed_check_bit<win>
+		{
+			static const bool available = true;
+			static const DWORD mask = 0x10000000;
+		};
+
+		template<class T>
+		struct last_error_if_t
+		{
+			typedef void is_error_handler;
+
+			T invalid;
+
+			explicit last_error_if_t(T invalid) : invalid(invalid) {}
+
+			inline result<T, win> operator()(T r) const {
+				if (r != invalid) [[likely]] { return result<T, win>{ win{ NOERROR }, r }; }
+				const DWORD e = GetLastError();
+				detail::count_failure(handler_id::last_error_if, domain::win, e);
+				return result<T, win>{ win{ e }, r };
+			}
+		};
+		template<class T>
+		last_error_if_t<T> last_error_if(T invalid) { return last_error_if_t<T>(invalid); }
+
+		template<>
+		struct pending_status<win>
+		{
+			static const bool available = true;
+			static const DWORD value = ERROR_IO_PENDING;
+		};
+
+		// for overlapped ReadFile, WSARecv, ConnectEx, ... where invalid with ERROR_IO_PENDING is the queued fast path
+		template<class T>
+		struct pending_ok_if_t
+		{
+			typedef void is_error_handler;
+
+			T invalid;
+
+			explicit pending_ok_if_t(T invalid) : invalid(invalid) {}
+
+			inline pending_result<T, win> operator()(T r) const {
+				if (r != invalid) { return pending_result<T, win>{ win{ NOERROR }, r }; }
+				const DWORD e = GetLastError();
+				if (e != ERROR_IO_PENDING) [[unlikely]] { detail::count_failure(handler_id::pending_ok_if, domain::win, e); }
+				return pending_result<T, win>{ win{ e }, r };
+			}
+		};
+		template<class T>
+		pending_ok_if_t<T> pending_ok_if(T invalid) { return pending_ok_if_t<T>(invalid); }
+
+#if UDLERRORS_EXCEPTIONS
+		struct win_exception : public error_exception
+		{
+			win error;
+
+			explicit win_exception(const win& e) : error_exception(e), error(e) {}
+		};
+
+		namespace detail {
+			// kept out of line so that the handlers inline only the compare and branch
+			[[noreturn]] inline __declspec(noinline) void throw_last_error() {
+				const DWORD e = GetLastError();
+				count_failure(handler_id::throw_last_error_if, domain::win, e, _ReturnAddress());
+				throw win_exception{ win{ e } };
+			}
+		}
+#else
+		namespace detail {
+			inline __declspec(noinline) void throw_last_error() noexcept {
+				const DWORD e = GetLastError();
+				count_failure(handler_id::throw_last_error_if, domain::win, e, _ReturnAddress());
+				report_failure(domain::win, e);
+			}
+		}
+#endif
+
+		template<class T>
+		struct throw_last_error_if_t
+		{
+			typedef void is_error_handler;
+
+			T invalid;
+
+			explicit throw_last_error_if_t(T invalid) : invalid(invalid) {}
+
+			inline T operator()(T r) const { if (r != invalid) [[likely]] { return r; } detail::throw_last_error(); return r; }
+		};
+		template<class T>
+		throw_last_error_if_t<T> throw_last_error_if(T invalid) { return throw_last_error_if_t<T>(invalid); }
+
+		// traits for unique_handle
+		// invalid() - the value returned on failure and held when empty, close(h) - release a valid handle
+		struct null_handle_traits
+		{
+			typedef HANDLE type;
+
+			static constexpr type invalid() noexcept { return nullptr; }
+			static void close(type h) noexcept { ::CloseHandle(h); }
+		};
+		struct invalid_handle_traits
+		{
+			typedef HANDLE type;
+
+			static type invalid() noexcept { return INVALID_HANDLE_VALUE; }
+			static void close(type h) noexcept { ::CloseHandle(h); }
+		};
+
+		// unique_handle<Traits> - an owned handle and the error from the call that created it
+		// the handle is closed on destruction, the error has the same obligation to be checked as unique_error
+		template<class Traits, class CheckPolicy = default_check>
+		class unique_handle
+		{
+		public:
+			typedef typename Traits::type handle_type;
+
+		private:
+			handle_type h;
+			unique_error<win, CheckPolicy> err;
+
+		public:
+			unique_handle() noexcept : h(Traits::invalid()) {}
+			explicit unique_handle(handle_type h) noexcept : h(h) {}
+			explicit unique_handle(win e, const std::source_location& where = std::source_location::current()) noexcept : h(Traits::invalid()), err(e, where) {}
+
+			~unique_handle() { reset(); }
+
+			unique_handle(const unique_handle&) = delete;
+			unique_handle& operator=(const unique_handle&) = delete;
+
+			unique_handle(unique_handle&& o) noexcept : h(o.release()), err(std::move(o.err)) {}
+			unique_handle& operator=(unique_handle&& o) noexcept { if (this != &o) { reset(o.release()); err = std::move(o.err); } return *this; }
+
+			bool ok() const noexcept { return err.ok(); }
+			explicit operator bool() const noexcept { return ok(); }
+
+			bool valid() const noexcept { return h != Traits::invalid(); }
+			handle_type get() const noexcept { return h; }
+			handle_type release() noexcept { handle_type result = h; h = Traits::invalid(); return result; }
+			void reset(handle_type n = Traits::invalid()) noexcept { if (valid()) { Traits::close(h); } h = n; }
+
+			unique_error<win, CheckPolicy>& error() noexcept { return err; }
+			const unique_error<win, CheckPolicy>& error() const noexcept { return err; }
+		};
+
+		template<class Traits, class CheckPolicy> bool ok(const unique_handle<Traits, CheckPolicy>& h) noexcept { return h.ok(); }
+
+		template<class Traits, class CheckPolicy = default_check>
+		struct make_handle_or_error_t
+		{
+			typedef void is_error_handler;
+
+			std::source_location where;
+
+			explicit make_handle_or_error_t(const std::source_location& where) noexcept : where(where) {}
+
+			inline unique_handle<Traits, CheckPolicy> operator()(typename Traits::type h) const {
+				if (h != Traits::invalid()) [[likely]] { return unique_handle<Traits, CheckPolicy>{ h }; }
+				const DWORD e = GetLastError();
+				detail::count_failure(handler_id::make_handle_or_error, domain::win, e);
+				return unique_handle<Traits, CheckPolicy>{ win{ e }, where };
+			}
+		};
+		// CreateEvent(...) || make_handle_or_error<null_handle_traits>()
+		template<class Traits, class CheckPolicy = default_check>
+		make_handle_or_error_t<Traits, CheckPolicy> make_handle_or_error(const std::source_location& where = std::source_location::current()) { return make_handle_or_error_t<Traits, CheckPolicy>(where); }
+
+		typedef unique_handle<null_handle_traits> unique_null_handle;
+		typedef unique_handle<invalid_handle_traits> unique_file_handle;
+	}
+	inline namespace literals {
+		inline namespace win_literals {
+			constexpr error::win operator "" _win(unsigned long long err) noexcept {
+				return error::win{ DWORD(err) };
+			}
+		}
+	}
+}
+
+UDLERRORS_END_EXPORT
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(ok(0_win) && !ok(5_win) && ok(win{}) && 5_win != 0_win, "win classification must be constexpr");
+		static_assert(ok(result<BOOL, win>{ 0_win, TRUE }), "result classification must be constexpr");
+		static_assert(pending_result<BOOL, win>{ win{ ERROR_IO_PENDING }, FALSE }.state() == completion::pending && pending_result<BOOL, win>{ 0_win, TRUE }.completed() && pending_result<BOOL, win>{ 5_win, FALSE }.failed(), "win pending classification must be constexpr");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
@@ -0,0 +1,22 @@
+// uses the library through import udlerrors; so every build checks the module interface as an importer sees it
+// macros do not cross import, the WIN32 declarations and constants come from windows.h
+// main.cpp includes the headers in the same program, the module attaches them to the global module so both share one copy of the library state
+
+#include <windows.h>
+
+import udlerrors;
+
+using namespace error;
+
+bool imported_module_works() {
+	CLSID clsid = {};
+	auto created = CoCreateGuid(&clsid) || return_hr;
+	if (!created) {
+		return false;
+	}
+	if (!ok(0_win) || to_hr(win{ ERROR_ACCESS_DENIED }) != hr{ E_ACCESSDENIED }) {
+		return false;
+	}
+	unique_error<hr> hres{ E_FAIL };
+	return !hres && !message(win{ ERROR_ACCESS_DENIED }).empty();
+}
@@ -1,246 +1,49 @@
-#define WIN32_NO_STATUS
-#include <windows.h>
-#undef WIN32_NO_STATUS
-
-#include <winternl.h>
-#include <ntstatus.h>
+#include "udlerrors.h"
 
 #include <cassert>
-#include <functional>
-
-namespace error {
-	inline namespace v0_1_0 {
-		template<class T, class IsError = typename T::is_error> bool ok(const T& t) { return !!t; }
-
-		template<class T, class IsError = typename T::is_error>
-		class unique_error 
-		{
-			T error;
-			mutable bool issafe;
-
-			void safe_or_terminate() const { if (!issafe) { std::terminate(); } }
-
-		public:
-			~unique_error() { safe_or_terminate(); }
-
-			unique_error() : issafe(true) {}
-			template<class V>
-			unique_error(V v) : error(v), issafe(false) {}
-
-			unique_error(const unique_error& o) : error(o.error), issafe(o.issafe) { o.issafe = true; }
-			unique_error& operator=(const unique_error& o) { error = o.error; issafe = o.issafe; o.issafe = true; return *this; }
-
-			bool ok() const { issafe = true;  return error::ok(error); }
-			explicit operator bool() const { return ok(); }
-
-			T& get() { return error; }
-			const T& get() const { return error; }
-
-			bool is_safe() const { return issafe; }
-
-			unique_error& reset() { safe_or_terminate(); error = T{}; issafe = true; return *this; }
-			template<class V>
-			unique_error& reset(V v) { safe_or_terminate(); error = T{v}; issafe = false; return *this; }
-
-			T release() { T result = error; error = T{}; issafe = true; return result; }
-		};
-
-		template<class T, class IsError = typename T::is_error> bool ok(const unique_error<T>& t) { return t.ok(); }
+#include <thread>
+#include <vector>
 
-		struct error_exception : public std::exception 
-		{
-			bool isok;
+namespace e = error;
+using namespace error;
 
-			template<class T, class IsError = T::is_error> explicit error_exception(const T& e) : isok(error::ok(e)) {}
+// defined in import.cpp, which uses the library through the named module
+bool imported_module_works();
 
-			bool ok() const { return isok; }
-			explicit operator bool() const { return ok(); }
-		};
+namespace {
+	task<CLSID> create_clsid() {
+		CLSID clsid = {};
+		co_await (CoCreateGuid(&clsid) || e::return_hr); // a failure completes the task with the error
+		co_return clsid;
 	}
-}
-template<class T, class IsError = typename T::is_error> bool operator==(const T& lhs, const T& rhs) {
-	return lhs.value == rhs.value;
-}
-template<class T, class IsError = typename T::is_error> bool operator!=(const T& lhs, const T& rhs) {
-	return lhs.value != rhs.value;
-}
 
-template<class ReturnT, class T, class IsErrorHandler = typename T::is_error_handler> auto operator||(const ReturnT& result, const T& handler)
-	-> decltype(handler(result)) {
-	return		handler(result);
-}
-
-template<class T, class IsError = typename T::is_error> bool operator==(const error::unique_error<T>& lhs, const T& rhs) {
-	return lhs.get().value == rhs.value;
-}
-template<class T, class IsError = typename T::is_error> bool operator!=(const error::unique_error<T>& lhs, const T& rhs) {
-	return lhs.get().value != rhs.value;
-}
-template<class T, class IsError = typename T::is_error> bool operator==(const T& lhs, const error::unique_error<T>& rhs) {
-	return lhs.value == rhs.get().value;
-}
-template<class T, class IsError = typename T::is_error> bool operator!=(const T& lhs, const error::unique_error<T>& rhs) {
-	return lhs.value != rhs.get().value;
-}
-template<class T, class IsError = typename T::is_error> bool operator==(const error::unique_error<T>& lhs, const error::unique_error<T>& rhs) {
-	return lhs.get().value == rhs.get().value;
-}
-template<class T, class IsError = typename T::is_error> bool operator!=(const error::unique_error<T>& lhs, const error::unique_error<T>& rhs) {
-	return lhs.get().value != rhs.get().value;
-}
-
-namespace error {
-	inline namespace v0_1_0 {
-		struct win
-		{
-			typedef void is_error;
-
-			constexpr inline win() : value(NOERROR) {}
-			constexpr inline explicit win(DWORD e) : value(e) {}
-
-			inline explicit operator bool () const { return value == 0; }
-
-			DWORD value;
-		};
-
-		template<class T>
-		struct last_error_if_t
-		{
-			typedef void is_error_handler;
-
-			T invalid;
-
-			explicit last_error_if_t(T invalid) : invalid(invalid) {}
-
-			inline std::pair<win, T> operator()(T r) const { return std::make_pair(win{ (r == invalid) ? GetLastError() : NOERROR }, r); }
-		};
-		template<class T>
-		last_error_if_t<T> last_error_if(T invalid) { return last_error_if_t<T>(invalid); }
-
-		struct win_exception : public error_exception
-		{
-			win error;
-
-			explicit win_exception(const win& e) : error_exception(e), error(e) {}
-		};
-
-		template<class T>
-		struct throw_last_error_if_t
-		{
-			typedef void is_error_handler;
-
-			T invalid;
-
-			explicit throw_last_error_if_t(T invalid) : invalid(invalid) {}
-
-			inline T operator()(T r) const { if (r != invalid) return r; throw win_exception{ win{ GetLastError() } }; }
-		};
-		template<class T>
-		throw_last_error_if_t<T> throw_last_error_if(T invalid) { return throw_last_error_if_t<T>(invalid); }
-	}
-	inline namespace literals {
-		inline namespace win_literals {
-			constexpr error::win operator "" _win(unsigned long long err) {
-				return error::win{ DWORD(err) };
-			}
+	task<void> create_two() {
+		CLSID first = co_await create_clsid();
+		CLSID second = co_await create_clsid();
+		if (first.Data1 == second.Data1) {
+			co_await hr{ E_FAIL };
 		}
 	}
-}
-namespace error {
-	inline namespace v0_1_0 {
-		struct nt
-		{
-			typedef void is_error;
-
-			constexpr inline nt() : value(STATUS_SUCCESS) {}
-			constexpr inline explicit nt(NTSTATUS nt) : value(nt) {}
-
-			inline explicit operator bool() const { return error(); }
 
-			bool success() const {
-				return NT_SUCCESS(value);
-			}
-			bool information() const {
-				return NT_INFORMATION(value);
-			}
-			bool warning() const {
-				return NT_WARNING(value);
-			}
-			bool error() const {
-				return NT_ERROR(value);
-			}
+	enum class next_step { fail, retry, wait };
 
-			NTSTATUS value;
-		};
-		struct nt_exception : public error_exception
-		{
-			nt error;
+	// what to do after a failed call - sharing and lock violations clear up, rpc failures are transient
+	constexpr auto after_failure = dispatch<hr, next_step>(next_step::fail)
+		.codes(FACILITY_WIN32, ERROR_SHARING_VIOLATION, ERROR_LOCK_VIOLATION, next_step::wait)
+		.code(FACILITY_WIN32, ERROR_RETRY, next_step::retry)
+		.facility(FACILITY_RPC, next_step::retry)
+		.compile();
+	static_assert(after_failure(to_hr(win{ ERROR_SHARING_VIOLATION })) == next_step::wait && after_failure(hr{ E_FAIL }) == next_step::fail, "the table is built at compile time");
 
-			explicit nt_exception(const nt& e) : error_exception(e), error(e) {}
-		};
-		struct throw_nt_t
-		{
-			typedef void is_error_handler;
-
-			inline void operator()(NTSTATUS v) const { auto nte = nt{ v }; if (nte) return; throw nt_exception{ nte }; }
-		};
-		throw_nt_t throw_nt{};
-	}
-	inline namespace literals {
-		inline namespace nt_literals {
-			constexpr error::nt operator "" _nt(unsigned long long nt) {
-				return error::nt{ NTSTATUS(nt) };
-			}
-		}
-	}
+	result<void, hr> open_store() { return trace(E_FAIL || e::return_hr); }
+	result<void, hr> load_settings() { return trace(open_store()); }
 }
-namespace error {
-	inline namespace v0_1_0 {
-		struct hr
-		{
-			typedef void is_error;
 
-			constexpr inline hr() : value(S_OK) {}
-			constexpr inline explicit hr(HRESULT hr) : value(hr) {}
-
-			inline explicit operator bool() const { return succeeded(); }
-
-			bool succeeded() const {
-				return SUCCEEDED(value);
-			}
-			bool failed() const {
-				return FAILED(value);
-			}
-
-			HRESULT value;
-		};
-		struct hr_exception : public error_exception
-		{
-			hr error;
-
-			explicit hr_exception(const hr& e) : error_exception(e), error(e) {}
-		};
-		struct throw_hr_t
-		{
-			typedef void is_error_handler;
+int wmain() {
 
-			inline void operator()(HRESULT v) const { auto hre = hr{ v }; if (hre) return; throw hr_exception{ hre }; }
-		};
-		throw_hr_t throw_hr{};
-	}
-	inline namespace literals {
-		inline namespace hr_literals {
-			constexpr error::hr operator "" _hr(unsigned long long hr) {
-				return error::hr{ HRESULT(hr) };
-			}
-		}
+	if (!imported_module_works()) {
+		return -1;
 	}
-}
-
-namespace e = error;
-using namespace error;
-
-int wmain() {
 
 	if (ok(win{ NOERROR })) {
 	}
@@ -266,6 +69,68 @@ int wmain() {
 	if (0_hr != 1_hr) {
 	}
 
+	{
+		constexpr win mapped = to_win(nt{ STATUS_OBJECT_NAME_NOT_FOUND }); // table lookup at compile time
+		win translated = to_win(nt{ NTSTATUS(0xC0000185) }); // not in the table, RtlNtStatusToDosError
+		if (to_hr(mapped) != to_hr(win{ ERROR_FILE_NOT_FOUND }) || ok(translated)) {
+			return -1;
+		}
+	}
+
+	{
+		std::error_code code = win{ ERROR_ACCESS_DENIED }; // nothing is allocated, the category is a constant
+		if (code != win{ ERROR_ACCESS_DENIED } || nt{ STATUS_ACCESS_DENIED } != code || hr{ E_ACCESSDENIED } != code || code != std::errc::permission_denied) {
+			return -1;
+		}
+	}
+
+	{
+		// ntdll is resolved on the first call, the wrappers return nt and result<T, nt>
+		auto io_pending = ntdll::query_information_thread<ULONG>(GetCurrentThread(), ThreadIsIoPending);
+		if (!io_pending) {
+			return -1;
+		}
+		ntdll::NtClose(CreateEvent(nullptr, TRUE, TRUE, nullptr) || throw_last_error_if(HANDLE(NULL))) || e::throw_nt;
+	}
+
+	{
+		auto text = message(win{ ERROR_ACCESS_DENIED }); // formatted once, then read from the cache
+		if (text.data() != message(win{ ERROR_ACCESS_DENIED }).data()) {
+			return -1;
+		}
+		wchar_t buffer[64];
+		message(nt{ STATUS_ACCESS_DENIED }, buffer, 64);
+	}
+
+	{
+		NTSTATUS statuses[] = { STATUS_SUCCESS, STATUS_PENDING, STATUS_BUFFER_OVERFLOW, STATUS_ACCESS_DENIED, STATUS_SUCCESS };
+		if (all_ok<nt>(statuses) || first_failure<nt>(statuses) != 3 || count_failures<nt>(statuses) != 1) {
+			return -1;
+		}
+		std::vector<hr> results(100, 0_hr);
+		results[42] = hr{ E_FAIL };
+		if (partition_failures<hr>(results) != 99 || results[99] != hr{ E_FAIL }) {
+			return -1;
+		}
+	}
+
+	{
+		// a batch of calls checked together, GetLastError is only read for the calls that failed
+		HANDLE events[4] = {};
+		for (HANDLE& event : events) {
+			event = CreateEvent(nullptr, TRUE, TRUE, nullptr) || throw_last_error_if(HANDLE(NULL));
+		}
+		batch_result<win> closed;
+		for (HANDLE event : events) {
+			closed.push(CloseHandle(event) || last_error_if(FALSE));
+		}
+		NTSTATUS statuses[] = { STATUS_SUCCESS, STATUS_ACCESS_DENIED, STATUS_PENDING, STATUS_ACCESS_DENIED };
+		auto queried = statuses || return_each<nt>; // classified in one pass, with one bit per failure
+		if (!closed || queried.failures() != 2 || queried.next_failure() != 1 || queried.next_failure(2) != 3 || queried.error(3) != nt{ STATUS_ACCESS_DENIED }) {
+			return -1;
+		}
+	}
+
 
 	{
 		HANDLE event = nullptr;
@@ -274,10 +139,30 @@ int wmain() {
 	}
 
 	{
-		unique_error<win> err;
-		HANDLE event = nullptr;
+		auto event = CreateEvent(nullptr, TRUE, TRUE, nullptr) || make_handle_or_error<null_handle_traits>(); // closed when event goes out of scope
+		if (!event) // checking makes the error in event safe
+		{
+			return -1;
+		}
+		WaitForSingleObject(event.get(), 0);
+		unique_null_handle moved = std::move(event);
+		assert(!event.valid() && moved.valid());
+	}
+
+	{
+		auto event = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		if (!event)
+		{
+			return -1;
+		}
+		CloseHandle(event.value());
+	}
+
+	{
+		auto r = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		unique_error<win> err = r.error();
+		HANDLE event = r.value();
 
-		std::tie(err, event) = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
 		assert(!err.is_safe());
 		if (!err) // checking makes err safe
 		{
@@ -287,10 +172,10 @@ int wmain() {
 	}
 
 	{
-		unique_error<win> err;
-		HANDLE event = nullptr;
+		auto r = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		unique_error<win> err = r.error();
+		HANDLE event = r.value();
 
-		std::tie(err, event) = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
 		assert(!err.is_safe());
 		if (err == win{ NOERROR }) {
 			// use event
@@ -305,6 +190,75 @@ int wmain() {
 		CoCreateGuid(&clsid) || e::throw_hr;
 	}
 
+	{
+		HANDLE file = CreateFileW(L"udlerrors.tmp", GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, nullptr) || throw_last_error_if(INVALID_HANDLE_VALUE);
+		OVERLAPPED overlapped = {};
+		const char data[] = "udlerrors";
+		auto written = WriteFile(file, data, sizeof(data), nullptr, &overlapped) || pending_ok_if(FALSE); // ERROR_IO_PENDING is not a failure
+		if (written.failed()) {
+			CloseHandle(file);
+			return -1;
+		}
+		if (written.pending()) {
+			DWORD bytes = 0;
+			GetOverlappedResult(file, &overlapped, &bytes, TRUE) || throw_last_error_if(FALSE);
+		}
+		CloseHandle(file);
+	}
+
+	{
+		auto t = create_two();
+		t.start();
+		assert(t.done());
+		if (!t) // checking makes the outcome of the task safe
+		{
+			return -1;
+		}
+	}
+
+	{
+		// value() of a failed task reports the error instead of reading a value that was never returned
+		failure_hook previous = set_failure_hook(&record_on_failure);
+		auto t = []() -> task<CLSID> { co_await hr{ E_FAIL }; co_return CLSID{}; }();
+		t.start();
+		const CLSID clsid = t.value();
+		set_failure_hook(previous);
+		if (take_failure().code != ULONG(E_FAIL) || clsid.Data1 != 0) {
+			return -1;
+		}
+	}
+
+#if UDLERRORS_EXCEPTIONS
+	try {
+		E_FAIL || e::throw_hr;
+	}
+	catch (const hr_exception& ex) {
+		const char* text = ex.what(); // "hr 0x80004005: Unspecified error", formatted in place
+		assert(text[0] == 'h');
+	}
+#else
+	{
+		// without exceptions the failure goes to the hook, this one keeps it for the thread and returns
+		failure_hook previous = set_failure_hook(&record_on_failure);
+		E_FAIL || e::throw_hr;
+		set_failure_hook(previous);
+		if (take_failure().code != ULONG(E_FAIL)) {
+			return -1;
+		}
+	}
+#endif
+
+	{
+		CLSID clsid = {};
+		auto hres = (CoCreateGuid(&clsid) || e::return_hr)
+			.and_then([&]() { return CoCreateGuid(&clsid) || e::return_hr; })
+			.or_else([](hr) { return result<void, hr>{ hr{ S_OK } }; });
+		if (!hres)
+		{
+			return -1;
+		}
+	}
+
 	{
 		unique_error<hr> hres;
 		CLSID clsid = {};
@@ -328,27 +282,156 @@ int wmain() {
 		assert(hres.is_safe());
 	}
 
+	{
+		CLSID clsid = {};
+		hr created;
+		for (int attempt = 0; attempt != 3; ++attempt) {
+			created = hr{ CoCreateGuid(&clsid) };
+			if (ok(created) || after_failure(created) == next_step::fail) {
+				break;
+			}
+			if (after_failure(created) == next_step::wait) {
+				Sleep(10);
+			}
+		}
+		if (!ok(created)) {
+			return -1;
+		}
+	}
+
+	{
+		auto loaded = load_settings(); // with UDLERRORS_TRAIL each layer pushes a frame for the failure
+		if (loaded) {
+			return -1;
+		}
+		error_frame frames[8];
+		assert(error_trail(frames, 8) == (UDLERRORS_TRAIL ? 2 : 0));
+		dump_error_trail();
+	}
+
+	{
+		// the first failure from any worker is kept, the others stop once they see cancelled()
+		first_error<hr> failed;
+		std::vector<std::thread> workers;
+		for (int w = 0; w != 4; ++w) {
+			workers.emplace_back([&failed]() {
+				for (int i = 0; i != 100 && !failed.cancelled(); ++i) {
+					CLSID clsid = {};
+					failed.set(hr{ CoCreateGuid(&clsid) });
+				}
+			});
+		}
+		for (auto& w : workers) {
+			w.join();
+		}
+		if (!failed.join()) // checking makes the joined error safe
+		{
+			return -1;
+		}
+	}
+
+	{
+		// one completion status read by every listener, any one listener checking it is enough
+		CLSID clsid = {};
+		shared_error<hr> completed{ CoCreateGuid(&clsid) };
+		// each listener also checks a status of its own, padded so that the checks do not contend for a cache line
+		padded_shared_error<hr> own[4] = { S_OK, S_OK, S_OK, S_OK };
+		static_assert(sizeof(own[0]) == 64, "padded errors do not share a cache line");
+		std::vector<std::thread> listeners;
+		for (int l = 0; l != 4; ++l) {
+			listeners.emplace_back([&completed, &own, l]() {
+				if (!ok(completed) || !ok(own[l])) {
+					std::abort();
+				}
+			});
+		}
+		for (auto& l : listeners) {
+			l.join();
+		}
+		assert(completed.is_safe());
+	}
+
+	{
+		std::vector<unique_error<hr>> results;
+		CLSID clsid = {};
+		results.emplace_back(CoCreateGuid(&clsid));
+		results.emplace_back(CoCreateGuid(&clsid)); // growing moves the unchecked errors
+		unique_error<hr> first = std::move(results.front());
+		assert(results.front().is_safe());
+		if (!first) // checking makes first safe
+		{
+			return -1;
+		}
+		for (auto& r : results) {
+			r.release();
+		}
+	}
+
+	{
+		{
+			unique_error<hr, record_if_unchecked> dropped{ E_FAIL }; // this line is recorded when dropped goes out of scope unchecked
+		}
+		unchecked_error recorded[1];
+		if (unchecked_errors(recorded, 1) != 1 || recorded[0].code != ULONG(E_FAIL)) {
+			return -1;
+		}
+	}
+
+	{
+		// the unchecked flag lives in a reserved bit, so the table stays 4 bytes per entry
+		unique_error<win, packed_check<terminate_if_unchecked>> status[16];
+		status[3].reset(win{ ERROR_ACCESS_DENIED });
+		assert(!status[3].is_safe());
+		assert(status[3].get() == win{ ERROR_ACCESS_DENIED });
+		if (ok(status[3])) {
+			return -1;
+		}
+		assert(status[3].is_safe());
+	}
+
+	{
+		// a file that another process has open fails with a sharing violation until it is closed
+		auto opened = retry_if({ win{ ERROR_SHARING_VIOLATION }, win{ ERROR_LOCK_VIOLATION } }) || []() {
+			return CreateFileW(L"udlerrors.retry", GENERIC_READ, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr)
+				|| make_handle_or_error<invalid_handle_traits>();
+		};
+		if (!opened.ok()) {
+			return -1;
+		}
+
+		// the dispatch table decides what is transient
+		GUID clsid = {};
+		auto created = retry_if([](hr e) { return after_failure(e) != next_step::fail; }, retry_policy{ .spins = 2, .yields = 1, .sleeps = 1 }) || [&]() {
+			return CoCreateGuid(&clsid) || return_hr;
+		};
+		if (!created.ok() || created.retries != 0) {
+			return -1;
+		}
+	}
+
 #if 0
 	{
-		unique_error<win> err;
-		HANDLE event = nullptr;
+		auto r = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		unique_error<win> err = r.error();
+		HANDLE event = r.value();
 
-		std::tie(err, event) = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
 		assert(!err.is_safe());
 		CloseHandle(event);
 		// terminate called here because err is not checked or released
 	}
 
 	{
-		unique_error<win> err;
-		HANDLE event = nullptr;
+		auto r = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		unique_error<win> err = r.error();
+		HANDLE event = r.value();
 
-		std::tie(err, event) = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
 		assert(!err.is_safe());
 		CloseHandle(event);
 
 		// terminate called here because err is not checked
-		std::tie(err, event) = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		r = CreateEvent(nullptr, TRUE, TRUE, nullptr) || last_error_if(HANDLE(NULL));
+		err = r.error();
+		event = r.value();
 		assert(!err.is_safe());
 		if (ok(err))
 		{
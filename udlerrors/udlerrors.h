@@ -0,0 +1,31 @@
+#pragma once
+
+// the whole library, include the headers in error/ for a part of it
+// error/hr.h does not pull in winternl.h or ntstatus.h
+
+#include "error/core.h"
+#include "error/counters.h"
+#include "error/log_record.h"
+#include "error/hooks.h"
+#include "error/trail.h"
+#include "error/message.h"
+#include "error/win.h"
+#include "error/nt.h"
+#include "error/ntdll.h"
+#include "error/hr.h"
+#include "error/conversions.h"
+#include "error/error_code.h"
+#include "error/dispatch.h"
+#include "error/retry.h"
+#include "error/log.h"
+#include "error/bulk.h"
+#include "error/shared.h"
+#include "error/task.h"
+
+UDLERRORS_END_EXPORT
+namespace error {
+	inline namespace v0_1_0 {
+		static_assert(detail::failed<domain::nt>(ULONG(STATUS_ACCESS_DENIED)) == !ok(nt{ STATUS_ACCESS_DENIED }) && detail::failed<domain::nt>(ULONG(STATUS_BUFFER_OVERFLOW)) == !ok(nt{ STATUS_BUFFER_OVERFLOW }), "bulk nt test must match ok(nt)");
+	}
+}
+UDLERRORS_BEGIN_EXPORT
@@ -0,0 +1,53 @@
+// import udlerrors; for the whole library as a named module
+// the headers are wrapped in an export extern "C++" block, the system and std headers they include are in the global module fragment
+// the headers leave the export, not the extern "C++", around their static_asserts and std specializations with UDLERRORS_END_EXPORT and UDLERRORS_BEGIN_EXPORT
+// the configuration macros (UDLERRORS_CHECKED, UDLERRORS_EXCEPTIONS, ...) come from the build of this interface, not from the importer
+// macros do not cross import, so importers that use the WIN32 constants include windows.h and ntstatus.h themselves
+
+module;
+
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+#include <winternl.h>
+#include <ntstatus.h>
+#include <intrin.h>
+#include <immintrin.h>
+#if defined(UDLERRORS_COUNTERS) && UDLERRORS_COUNTERS
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+#endif
+#if defined(UDLERRORS_ERROR_INFO) && UDLERRORS_ERROR_INFO
+#include <oleauto.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+export module udlerrors;
+
+// extern "C++" attaches the declarations to the global module, so a program that both imports the module and includes
+// the headers has one failure hook, one set of counters and one message cache, not a copy owned by the module
+#define UDLERRORS_BEGIN_EXPORT } export extern "C++" {
+#define UDLERRORS_END_EXPORT } extern "C++" {
+
+export extern "C++" {
+#include "udlerrors.h"
+}